@@ -2,9 +2,15 @@
 
 #include "Animations/LSAnimInstance.h"
 
+#include "Animation/AnimMontage.h"
 #include "Characters/LSCharacterBase.h"
+#include "Components/SkeletalMeshComponent.h"
 #include "Curves/CurveFloat.h"
+#include "Data/TurnInPlaceSet.h"
+#include "Engine/World.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "Subsystems/LSClimbingIKSubsystem.h"
+#include "Subsystems/LSTraceSchedulerSubsystem.h"
 
 void ULSAnimInstance::NativeInitializeAnimation()
 {
@@ -13,6 +19,12 @@ void ULSAnimInstance::NativeInitializeAnimation()
 	{
 		Character = LSCharacter;
 		CharacterMovementComp = Character->GetCharacterMovement();
+		LocomotionEvents = Character->SubscribeLocomotionEvents();
+	}
+
+	if (TurnInPlaceSet)
+	{
+		TurnInPlaceSet->BuildMissingTables();
 	}
 }
 
@@ -21,29 +33,419 @@ void ULSAnimInstance::NativeUpdateAnimation(float DeltaSeconds)
 	Super::NativeUpdateAnimation(DeltaSeconds);
 	DeltaTimeX = DeltaSeconds;
 
-	if (DeltaTimeX == 0.f || IsValid(Character))
+	bHasCharacter = IsValid(Character);
+	if (DeltaTimeX == 0.f || !bHasCharacter)
+	{
+		return;
+	}
+
+	// Blueprint reads the values from the anim instance, so the snapshot is copied straight into it once per update.
+	Character->GetLocomotionSnapshot().Read(
+		[this](const FLSLocomotionSnapshot& Snapshot)
+		{
+			MovementInfo = Snapshot.MovementInfo;
+			MovementStates = Snapshot.MovementStates;
+			CharacterRotation = Snapshot.ActorRotation;
+		});
+
+	if (MovementStates.MovementState == ELSMovementState::InAir)
+	{
+		LandingPrediction = Character->GetLandingPrediction();
+		UpdateInAirValues();
+	}
+
+	if (MovementStates.MovementState == ELSMovementState::Grounded && MovementInfo.bIsMoving)
+	{
+		UpdateMovementValues();
+	}
+
+	if (MovementStates.MovementState == ELSMovementState::Grounded && !MovementInfo.bIsMoving && CanTurnInPlace())
+	{
+		TurnInPlaceCheck(DeltaSeconds);
+	}
+	else
+	{
+		ElapsedDelayTime = 0.f;
+	}
+
+	CopyClimbingLimbTargets();
+	UpdateFootIK();
+}
+
+void ULSAnimInstance::NativeThreadSafeUpdateAnimation(float DeltaSeconds)
+{
+	Super::NativeThreadSafeUpdateAnimation(DeltaSeconds);
+
+	if (DeltaSeconds == 0.f || !bHasCharacter)
+	{
+		return;
+	}
+
+	ProcessLocomotionEvents(DeltaSeconds);
+
+	if (ShouldUpdateAimingValues())
+	{
+		UpdateAimingValues(DeltaSeconds);
+	}
+
+	UpdateClimbingIK(DeltaSeconds);
+}
+
+void ULSAnimInstance::ResetLocomotionValues()
+{
+	check(IsInGameThread());
+	const ULSAnimInstance* Defaults = GetClass()->GetDefaultObject<ULSAnimInstance>();
+
+	// Wait for a running worker thread update, it reads the values reset here and drains the event queue.
+	GetSkelMeshComponent()->HandleExistingParallelEvaluationTask(true, false);
+
+	Montage_Stop(0.f);
+
+	MovementInfo = Defaults->MovementInfo;
+	MovementStates = Defaults->MovementStates;
+
+	// Aiming
+	SmoothedAimingRotation = Defaults->SmoothedAimingRotation;
+	SpineRotation = Defaults->SpineRotation;
+	AimingAngle = Defaults->AimingAngle;
+	SmoothedAimingAngle = Defaults->SmoothedAimingAngle;
+	AimSweepTime = Defaults->AimSweepTime;
+	InputYawTime = Defaults->InputYawTime;
+	ForwardYawTime = Defaults->ForwardYawTime;
+	LeftTawTime = Defaults->LeftTawTime;
+	RightYawTime = Defaults->RightYawTime;
+	LastAimingCharacterYaw = Defaults->LastAimingCharacterYaw;
+	LastAimingPitch = Defaults->LastAimingPitch;
+
+	// Turn In Place
+	ActiveTurn = FActiveTurnInPlace();
+	ElapsedDelayTime = 0.f;
+
+	// In Air
+	FallSpeed = Defaults->FallSpeed;
+	LandPrediction = Defaults->LandPrediction;
+	LandingPrediction = FLSLandingPrediction();
+
+	// Locomotion Events. A new queue drops the events pushed before the reset, the old one is released by the character's next push.
+	LocomotionEvents.Reset();
+	if (Character)
+	{
+		LocomotionEvents = Character->SubscribeLocomotionEvents();
+	}
+	bJumped = false;
+	bLanded = false;
+	JumpPlayRate = Defaults->JumpPlayRate;
+	LandSpeed = Defaults->LandSpeed;
+	JumpedTimeRemaining = 0.f;
+	LandedTimeRemaining = 0.f;
+
+	// Foot IK
+	FootIK_L = Defaults->FootIK_L;
+	FootIK_R = Defaults->FootIK_R;
+	PelvisOffset = Defaults->PelvisOffset;
+	PelvisAlpha = Defaults->PelvisAlpha;
+	FootGround[0] = FLSFootGroundCache();
+	FootGround[1] = FLSFootGroundCache();
+
+	// Climbing IK
+	ClimbingHandL = Defaults->ClimbingHandL;
+	ClimbingHandR = Defaults->ClimbingHandR;
+	ClimbingFootL = Defaults->ClimbingFootL;
+	ClimbingFootR = Defaults->ClimbingFootR;
+	ClimbingLimbTargets = FLSClimbingLimbTargets();
+
+	// Movement
+	VelocityBlend = Defaults->VelocityBlend;
+	VelocityBlendTarget = Defaults->VelocityBlendTarget;
+	StrideBlend = Defaults->StrideBlend;
+	StandingPlayRate = Defaults->StandingPlayRate;
+	WalkRunBlend = Defaults->WalkRunBlend;
+	CrouchingPlayRate = Defaults->CrouchingPlayRate;
+	UpdatesSinceMovementValues = 0;
+}
+
+#pragma region Aiming
+bool ULSAnimInstance::ShouldUpdateAimingValues() const
+{
+	if (MovementStates.RotationMode != ELSRotationMode::VelocityDirection)
+	{
+		return true;
+	}
+
+	// Moving input still drives Input Yaw Time, a turning capsule changes every aim angle and looking up or down changes the pitch.
+	if (MovementInfo.bHasMovementInput || MovementInfo.AimYawRate > LookingAroundMinAimYawRate || !FMath::IsNearlyEqual(CharacterRotation.Yaw, LastAimingCharacterYaw) ||
+		!FMath::IsNearlyEqual(MovementInfo.AimRotation.Pitch, LastAimingPitch))
+	{
+		return true;
+	}
+
+	// Keep going until the smoothed rotation has caught up with the current aim, not with the last updated one.
+	const FRotator& AimRotation = MovementInfo.AimRotation;
+	return !FMath::IsNearlyEqual(FRotator::NormalizeAxis(AimRotation.Yaw - SmoothedAimingRotation.Yaw), 0.0, 0.1) ||
+		!FMath::IsNearlyEqual(FRotator::NormalizeAxis(AimRotation.Pitch - SmoothedAimingRotation.Pitch), 0.0, 0.1);
+}
+
+void ULSAnimInstance::UpdateAimingValues(float DeltaSeconds)
+{
+	LastAimingCharacterYaw = CharacterRotation.Yaw;
+	LastAimingPitch = MovementInfo.AimRotation.Pitch;
+
+	// Smooth the world aim rotation per axis with one shared alpha, the same as RInterpTo without building rotators.
+	const FRotator& AimRotation = MovementInfo.AimRotation;
+	const float SmoothAlpha = FMath::Clamp(DeltaSeconds * SmoothedAimingRotationInterpSpeed, 0.f, 1.f);
+	SmoothedAimingRotation.Yaw = FRotator::NormalizeAxis(SmoothedAimingRotation.Yaw + FRotator::NormalizeAxis(AimRotation.Yaw - SmoothedAimingRotation.Yaw) * SmoothAlpha);
+	SmoothedAimingRotation.Pitch = FRotator::NormalizeAxis(SmoothedAimingRotation.Pitch + FRotator::NormalizeAxis(AimRotation.Pitch - SmoothedAimingRotation.Pitch) * SmoothAlpha);
+	SmoothedAimingRotation.Roll = 0.f;
+
+	// Unrotate both aim rotations relative to the actor once, as wrapped yaw and pitch deltas.
+	AimingAngle.X = FRotator::NormalizeAxis(AimRotation.Yaw - CharacterRotation.Yaw);
+	AimingAngle.Y = FRotator::NormalizeAxis(AimRotation.Pitch - CharacterRotation.Pitch);
+	SmoothedAimingAngle.X = FRotator::NormalizeAxis(SmoothedAimingRotation.Yaw - CharacterRotation.Yaw);
+	SmoothedAimingAngle.Y = FRotator::NormalizeAxis(SmoothedAimingRotation.Pitch - CharacterRotation.Pitch);
+
+	if (MovementStates.RotationMode != ELSRotationMode::VelocityDirection)
+	{
+		// Clamp the Aiming Pitch Angle to a range of 1 to 0 for use in the vertical aim sweeps.
+		AimSweepTime = FMath::GetMappedRangeValueClamped(FVector2f(-90.f, 90.f), FVector2f(1.f, 0.f), static_cast<float>(AimingAngle.Y));
+
+		// Use the Aiming Yaw Angle divided by the number of spine + pelvis bones to get the amount of spine rotation needed to remain facing the camera direction.
+		SpineRotation = FRotator(0.0, AimingAngle.X / 4.0, 0.0);
+	}
+	else if (MovementInfo.bHasMovementInput)
+	{
+		// Get the delta between the Movement Input rotation and Actor rotation and map it to a range of 0-1.
+		// This value is used in the aim offset behavior to make the character look toward the Movement Input.
+		const double InputYaw = FMath::RadiansToDegrees(FMath::Atan2(MovementInfo.MovementInput.Y, MovementInfo.MovementInput.X));
+		const float InputYawDelta = static_cast<float>(FRotator::NormalizeAxis(InputYaw - CharacterRotation.Yaw));
+		const float InputYawTarget = FMath::GetMappedRangeValueClamped(FVector2f(-180.f, 180.f), FVector2f(0.f, 1.f), InputYawDelta);
+		InputYawTime = FMath::FInterpTo(InputYawTime, InputYawTarget, DeltaSeconds, InputYawOffsetInterpSpeed);
+	}
+
+	// Separate the Aiming Yaw Angle into 3 separate Yaw Times. These 3 values are used in the Aim Offset behavior to improve the blending of the aim offset when rotating completely around the character.
+	// This allows you to keep the aiming responsive but still smoothly blend from left to right or right to left.
+	const float AbsSmoothedYaw = FMath::Abs(static_cast<float>(SmoothedAimingAngle.X));
+	LeftTawTime = FMath::GetMappedRangeValueClamped(FVector2f(0.f, 180.f), FVector2f(0.5f, 0.f), AbsSmoothedYaw);
+	RightYawTime = FMath::GetMappedRangeValueClamped(FVector2f(0.f, 180.f), FVector2f(0.5f, 1.f), AbsSmoothedYaw);
+	ForwardYawTime = FMath::GetMappedRangeValueClamped(FVector2f(-180.f, 180.f), FVector2f(0.f, 1.f), static_cast<float>(SmoothedAimingAngle.X));
+}
+#pragma endregion
+
+#pragma region Grounded
+bool ULSAnimInstance::ConsumeTurnInPlaceYaw(float& OutYaw)
+{
+	OutYaw = 0.f;
+
+	UAnimMontage* Montage = ActiveTurn.Montage.Get();
+	if (Montage == nullptr || ActiveTurn.Table == nullptr)
+	{
+		return false;
+	}
+
+	if (!Montage_IsPlaying(Montage))
+	{
+		ActiveTurn = FActiveTurnInPlace();
+		return false;
+	}
+
+	const float Position = Montage_GetPosition(Montage);
+	OutYaw = (ActiveTurn.Table->Sample(Position) - ActiveTurn.Table->Sample(ActiveTurn.LastPosition)) * ActiveTurn.RotationScale;
+	ActiveTurn.LastPosition = Position;
+	return FMath::Abs(OutYaw) > UE_KINDA_SMALL_NUMBER;
+}
+
+bool ULSAnimInstance::CanTurnInPlace() const
+{
+	return TurnInPlaceSet && MovementStates.RotationMode == ELSRotationMode::LookingDirection && MovementStates.ViewMode == ELSViewMode::ThirdPerson &&
+		   GetCurveValue(TEXT("Enable_Transition")) > 0.99f;
+}
+
+void ULSAnimInstance::TurnInPlaceCheck(float DeltaSeconds)
+{
+	// Step 1: Check if Aiming angle is outside of the Turn Check Min Angle, and if the Aim Yaw Rate is below the Aim Yaw Rate Limit.
+	// If so, begin counting the Elapsed Delay Time. If not, reset the Elapsed Delay Time.
+	// This ensures the conditions remain true for a sustained period of time before turning in place.
+	const float AbsAimingYaw = FMath::Abs(static_cast<float>(AimingAngle.X));
+	if (AbsAimingYaw <= TurnInPlaceSet->TurnCheckMinAngle || MovementInfo.AimYawRate >= TurnInPlaceSet->AimYawRateLimit)
+	{
+		ElapsedDelayTime = 0.f;
+		return;
+	}
+
+	// Step 2: Check if the Elapsed Delay time exceeds the set delay (mapped to the turn angle range). If so, trigger a Turn In Place.
+	ElapsedDelayTime += DeltaSeconds;
+	const float ClampedAimAngle = FMath::GetMappedRangeValueClamped(FVector2f(TurnInPlaceSet->TurnCheckMinAngle, 180.f), FVector2f(TurnInPlaceSet->MinAngleDelay, TurnInPlaceSet->MaxAngleDelay), AbsAimingYaw);
+	if (ElapsedDelayTime > ClampedAimAngle)
+	{
+		FRotator TargetRotation = CharacterRotation;
+		TargetRotation.Yaw = MovementInfo.AimRotation.Yaw;
+		TurnInPlace(TargetRotation, 1.f, 0.f, false);
+	}
+}
+
+void ULSAnimInstance::TurnInPlace(const FRotator& TargetRotation, float PlayRateScale, float StartTime, bool bOverrideCurrent)
+{
+	// Step 1: Set Turn Angle
+	const float TurnAngle = static_cast<float>(FRotator::NormalizeAxis(TargetRotation.Yaw - CharacterRotation.Yaw));
+
+	// Step 2: Choose Turn Asset based on the Turn Angle and Stance
+	const FLSTurnInPlaceAsset& TargetTurnAsset = TurnInPlaceSet->SelectAsset(TurnAngle, MovementStates.ActualStance);
+	if (TargetTurnAsset.Animation == nullptr || !TargetTurnAsset.Table.IsValid())
+	{
+		return;
+	}
+
+	// Step 3: If the Target Turn Animation is not playing or set to be overriden, play the turn animation as a dynamic montage.
+	if (!bOverrideCurrent && IsPlayingSlotAnimation(TargetTurnAsset.Animation, TargetTurnAsset.SlotName))
+	{
+		return;
+	}
+
+	const float PlayRate = TargetTurnAsset.PlayRate * PlayRateScale;
+	UAnimMontage* Montage = PlaySlotAnimationAsDynamicMontage(TargetTurnAsset.Animation, TargetTurnAsset.SlotName, 0.2f, 0.2f, PlayRate, 1, 0.f, StartTime);
+	if (Montage == nullptr)
+	{
+		return;
+	}
+
+	// Step 4: Scale the rotation amount so the turn lands on the target, the table is sampled at montage time so the play rate is already accounted for.
+	ActiveTurn.Montage = Montage;
+	ActiveTurn.Table = &TargetTurnAsset.Table;
+	ActiveTurn.RotationScale = TargetTurnAsset.bScaleTurnAngle && !FMath::IsNearlyZero(TargetTurnAsset.AnimatedAngle) ? FMath::Abs(TurnAngle / TargetTurnAsset.AnimatedAngle) : 1.f;
+	ActiveTurn.LastPosition = StartTime;
+}
+#pragma endregion
+
+#pragma region In Air
+void ULSAnimInstance::UpdateInAirValues()
+{
+	// Update the fall speed. Setting this value only while in the air allows you to use it within the AnimGraph for the landing strength.
+	// If not, the Z velocity would return to 0 on landing.
+	FallSpeed = MovementInfo.Velocity.Z;
+
+	// Set the Land Prediction weight.
+	LandPrediction = CalculateLandPrediction();
+}
+
+float ULSAnimInstance::CalculateLandPrediction() const
+{
+	// Only predict landings while falling fast enough, and onto walkable ground.
+	if (FallSpeed >= -200.f || !LandingPrediction.bValid || !LandingPrediction.bWalkable)
+	{
+		return 0.f;
+	}
+
+	const float TimeAlpha = FMath::Clamp(LandingPrediction.TimeToLand / LandPredictionTime, 0.f, 1.f);
+	const float Weight = LandPredictionCurve ? LandPredictionCurve->GetFloatValue(TimeAlpha) : 1.f - TimeAlpha;
+	return FMath::Lerp(Weight, 0.f, GetCurveValue(TEXT("Mask_LandPrediction")));
+}
+#pragma endregion
+
+#pragma region Locomotion Events
+void ULSAnimInstance::ProcessLocomotionEvents(float DeltaSeconds)
+{
+	JumpedTimeRemaining -= DeltaSeconds;
+	LandedTimeRemaining -= DeltaSeconds;
+
+	if (LocomotionEvents.IsValid())
+	{
+		while (TOptional<FLSLocomotionEvent> Event = LocomotionEvents->Dequeue())
+		{
+			switch (Event->Type)
+			{
+				case ELSLocomotionEventType::Jumped:
+					JumpedTimeRemaining = LocomotionEventPulseDuration;
+					JumpPlayRate = FMath::GetMappedRangeValueClamped(FVector2f(0.f, 600.f), FVector2f(1.2f, 1.5f), Event->Speed);
+					break;
+				case ELSLocomotionEventType::Landed:
+					LandedTimeRemaining = LocomotionEventPulseDuration;
+					LandSpeed = Event->Speed;
+					break;
+				default:
+					// State changes already reach the anim graph through the movement states.
+					break;
+			}
+		}
+	}
+
+	bJumped = JumpedTimeRemaining > 0.f;
+	bLanded = LandedTimeRemaining > 0.f;
+}
+#pragma endregion
+
+#pragma region Climbing IK
+void ULSAnimInstance::CopyClimbingLimbTargets()
+{
+	const ULSClimbingIKSubsystem* ClimbingIKSubsystem = MovementStates.MovementState == ELSMovementState::Climbing ? GetWorld()->GetSubsystem<ULSClimbingIKSubsystem>() : nullptr;
+	const FLSClimbingLimbTargets* Targets = ClimbingIKSubsystem ? ClimbingIKSubsystem->FindLimbTargets(Character) : nullptr;
+	if (Targets)
 	{
+		ClimbingLimbTargets = *Targets;
 		return;
 	}
 
-	Character->GetMovementInfo(MovementInfo);
-	Character->GetMovementStates(MovementStates);
+	// Keep the last locations so the limbs blend out in place.
+	for (FLSClimbingLimbTarget& Target : ClimbingLimbTargets.Limbs)
+	{
+		Target.Alpha = 0.f;
+	}
+}
+
+void ULSAnimInstance::UpdateClimbingIK(float DeltaSeconds)
+{
+	FLSClimbingLimbTarget* Limbs[] = {&ClimbingHandL, &ClimbingHandR, &ClimbingFootL, &ClimbingFootR};
+	for (int32 LimbIndex = 0; LimbIndex < UE_ARRAY_COUNT(Limbs); ++LimbIndex)
+	{
+		FLSClimbingLimbTarget& Limb = *Limbs[LimbIndex];
+		const FLSClimbingLimbTarget& Target = ClimbingLimbTargets.Limbs[LimbIndex];
+		if (Limb.Alpha == 0.f && Target.Alpha == 0.f)
+		{
+			continue;
+		}
+
+		// A limb that was not placed yet snaps to its first target and only blends in.
+		if (Limb.Alpha == 0.f)
+		{
+			Limb.Location = Target.Location;
+			Limb.Normal = Target.Normal;
+		}
+		else if (Target.Alpha > 0.f)
+		{
+			Limb.Location = FMath::VInterpTo(Limb.Location, Target.Location, DeltaSeconds, ClimbingIKInterpSpeed);
+			Limb.Normal = FMath::VInterpTo(Limb.Normal, Target.Normal, DeltaSeconds, ClimbingIKInterpSpeed).GetSafeNormal();
+		}
+		Limb.Alpha = FMath::FInterpTo(Limb.Alpha, Target.Alpha, DeltaSeconds, ClimbingIKInterpSpeed);
+		if (Limb.Alpha < KINDA_SMALL_NUMBER)
+		{
+			Limb.Alpha = 0.f;
+		}
+	}
 }
+#pragma endregion
 
 #pragma region Movement
 void ULSAnimInstance::UpdateMovementValues()
 {
+	// On throttled updates the last targets are kept and only the Velocity Blend keeps easing towards them.
+	if (!bReducedWork || ++UpdatesSinceMovementValues >= ReducedWorkMovementUpdateInterval)
+	{
+		UpdatesSinceMovementValues = 0;
+		VelocityBlendTarget = CalculateVelocityBlend();
+		WalkRunBlend = CalculateWalkRunBlend();
+		StrideBlend = CalculateStrideBlend();
+		StandingPlayRate = CalculateStandingPlayRate();
+		CrouchingPlayRate = CalculateCrouchingPlayRate();
+	}
+
 	// Interp and set the Velocity Blend.
-	FVelocityBlend Target = CalculateVelocityBlend();
-	VelocityBlend.F = FMath::FInterpTo(VelocityBlend.F, Target.F, DeltaTimeX, VelocityBlendInterpSpeed);
-	VelocityBlend.B = FMath::FInterpTo(VelocityBlend.B, Target.B, DeltaTimeX, VelocityBlendInterpSpeed);
-	VelocityBlend.L = FMath::FInterpTo(VelocityBlend.L, Target.L, DeltaTimeX, VelocityBlendInterpSpeed);
-	VelocityBlend.R = FMath::FInterpTo(VelocityBlend.R, Target.R, DeltaTimeX, VelocityBlendInterpSpeed);
+	VelocityBlend.F = FMath::FInterpTo(VelocityBlend.F, VelocityBlendTarget.F, DeltaTimeX, VelocityBlendInterpSpeed);
+	VelocityBlend.B = FMath::FInterpTo(VelocityBlend.B, VelocityBlendTarget.B, DeltaTimeX, VelocityBlendInterpSpeed);
+	VelocityBlend.L = FMath::FInterpTo(VelocityBlend.L, VelocityBlendTarget.L, DeltaTimeX, VelocityBlendInterpSpeed);
+	VelocityBlend.R = FMath::FInterpTo(VelocityBlend.R, VelocityBlendTarget.R, DeltaTimeX, VelocityBlendInterpSpeed);
 }
 
 FVelocityBlend ULSAnimInstance::CalculateVelocityBlend()
 {
-	const FVector LocRelativeVelocityDir = Character->GetActorRotation().UnrotateVector(MovementInfo.Velocity.GetSafeNormal());
+	const FVector LocRelativeVelocityDir = CharacterRotation.UnrotateVector(MovementInfo.Velocity.GetSafeNormal());
 	float Sum = FMath::Abs(LocRelativeVelocityDir.X) + FMath::Abs(LocRelativeVelocityDir.Y) + FMath::Abs(LocRelativeVelocityDir.Z);
 	const FVector RelativeDirection = LocRelativeVelocityDir / Sum;
 
@@ -78,13 +480,13 @@ FVector ULSAnimInstance::CalculateRelativeAccelerationAmount()
 	{
 		const float MaxAcceleration = CharacterMovementComp->GetMaxAcceleration();
 		const FVector AccelerationNormal = MovementInfo.Acceleration.GetClampedToMaxSize(MaxAcceleration) / MaxAcceleration;
-		Res = Character->GetActorRotation().UnrotateVector(AccelerationNormal);
+		Res = CharacterRotation.UnrotateVector(AccelerationNormal);
 	}
 	else
 	{
 		const float MaxBrakingDeceleration = CharacterMovementComp->GetMaxBrakingDeceleration();
 		const FVector AccelerationNormal = MovementInfo.Acceleration.GetClampedToMaxSize(MaxBrakingDeceleration) / MaxBrakingDeceleration;
-		Res = Character->GetActorRotation().UnrotateVector(AccelerationNormal);
+		Res = CharacterRotation.UnrotateVector(AccelerationNormal);
 	}
 
 	return Res;
@@ -98,7 +500,7 @@ float ULSAnimInstance::CalculateWalkRunBlend()
 	{
 		Res = 1.0f;
 	}
-	return 0.0f;
+	return Res;
 }
 
 float ULSAnimInstance::CalculateStrideBlend()
@@ -110,6 +512,11 @@ float ULSAnimInstance::CalculateStrideBlend()
 	// preventing the character from needing to play a half walk+half run blend.
 	// The curves are used to map the stride amount to the speed for maximum control.
 
+	if (StrideBlend_N_Walk == nullptr || StrideBlend_N_Run == nullptr || StrideBlend_C_Walk == nullptr)
+	{
+		return 1.f;
+	}
+
 	const float WalkValue = StrideBlend_N_Walk->GetFloatValue(MovementInfo.Speed);
 	const float RunValue = StrideBlend_N_Run->GetFloatValue(MovementInfo.Speed);
 	const float StanceValue = FMath::Lerp(WalkValue, RunValue, GetAnimCurveClamped("Weight_Gait"));
@@ -140,4 +547,252 @@ float ULSAnimInstance::CalculateCrouchingPlayRate()
 	return FMath::Clamp(PlayRate, 0.f, 2.f);
 }
 
-#pragma endregion
\ No newline at end of file
+#pragma endregion
+
+#pragma region Foot IK
+void ULSAnimInstance::UpdateFootIK()
+{
+	// Update Foot Locking values.
+	SetFootLocking(TEXT("Enable_FootIK_L"), TEXT("FootLock_L"), IKFootLBone, FootIK_L);
+	SetFootLocking(TEXT("Enable_FootIK_R"), TEXT("FootLock_R"), IKFootRBone, FootIK_R);
+
+	if (MovementStates.MovementState == ELSMovementState::InAir)
+	{
+		// Reset IK Feet and Pelvis while In Air.
+		SetPelvisIKOffset(FVector::ZeroVector, FVector::ZeroVector);
+		ResetIKOffsets();
+	}
+	else if (MovementStates.MovementState != ELSMovementState::Ragdoll)
+	{
+		// Traces are not worth it on distant meshes, blend the offsets out instead.
+		if (GetOwningComponent()->GetPredictedLODLevel() > FootIKMaxLOD)
+		{
+			SetPelvisIKOffset(FVector::ZeroVector, FVector::ZeroVector);
+			ResetIKOffsets();
+			return;
+		}
+
+		// Update all Foot Lock and Foot Offset values when not In Air.
+		SetFootOffsets(TEXT("Enable_FootIK_L"), IKFootLBone, 0, FootIK_L);
+		SetFootOffsets(TEXT("Enable_FootIK_R"), IKFootRBone, 1, FootIK_R);
+		SetPelvisIKOffset(FootIK_L.OffsetTarget, FootIK_R.OffsetTarget);
+	}
+}
+
+void ULSAnimInstance::SetFootLocking(const FName& EnableFootIKCurve, const FName& FootLockCurve, const FName& IKFootBone, FLSFootIKValues& Foot)
+{
+	// Only update values if FootIK curve has a weight.
+	if (GetCurveValue(EnableFootIKCurve) <= 0.f)
+	{
+		return;
+	}
+
+	// Only update the Foot Lock Alpha if the new value is less than the current, or it equals 1.
+	// This makes it so that the foot can only blend out of the locked position or lock to a new position, and never blend in.
+	const float FootLockCurveValue = GetCurveValue(FootLockCurve);
+	if (FootLockCurveValue >= 0.99f || FootLockCurveValue < Foot.LockAlpha)
+	{
+		Foot.LockAlpha = FootLockCurveValue;
+	}
+
+	// If the Foot Lock curve equals 1, save the new lock location and rotation in component space.
+	if (Foot.LockAlpha >= 0.99f)
+	{
+		const FTransform SocketTransform = GetOwningComponent()->GetSocketTransform(IKFootBone, RTS_Component);
+		Foot.LockLocation = SocketTransform.GetLocation();
+		Foot.LockRotation = SocketTransform.Rotator();
+	}
+
+	// If the Foot Lock Alpha has a weight, update the Foot Lock offsets to keep the foot planted in place while the capsule moves.
+	if (Foot.LockAlpha > 0.f)
+	{
+		SetFootLockOffsets(Foot);
+	}
+}
+
+void ULSAnimInstance::SetFootLockOffsets(FLSFootIKValues& Foot)
+{
+	// Use the delta between the current and last updated rotation to find how much the foot should be rotated to remain planted on the ground.
+	FRotator RotationDifference = FRotator::ZeroRotator;
+	if (CharacterMovementComp->IsMovingOnGround())
+	{
+		RotationDifference = Character->GetActorRotation() - CharacterMovementComp->GetLastUpdateRotation();
+		RotationDifference.Normalize();
+	}
+
+	// Get the distance traveled between frames relative to the mesh rotation to find how much the foot should be offset to remain planted on the ground.
+	const FVector LocationDifference = GetOwningComponent()->GetComponentRotation().UnrotateVector(MovementInfo.Velocity * DeltaTimeX);
+
+	// Subtract the location difference from the current local location and rotate it by the rotation difference to keep the foot planted in component space.
+	Foot.LockLocation = (Foot.LockLocation - LocationDifference).RotateAngleAxis(RotationDifference.Yaw, FVector::DownVector);
+
+	// Subtract the rotation difference from the current local rotation to get the new local rotation.
+	Foot.LockRotation = (Foot.LockRotation - RotationDifference).GetNormalized();
+}
+
+void ULSAnimInstance::SetFootOffsets(const FName& EnableFootIKCurve, const FName& IKFootBone, int32 FootIndex, FLSFootIKValues& Foot)
+{
+	// Only update Foot IK offset values if the Foot IK curve has a weight. If it equals 0, clear the offset values.
+	if (GetCurveValue(EnableFootIKCurve) <= 0.f)
+	{
+		Foot.OffsetLocation = FVector::ZeroVector;
+		Foot.OffsetRotation = FRotator::ZeroRotator;
+		return;
+	}
+
+	// Find the ground under the foot, using the root bone height as the floor.
+	USkeletalMeshComponent* OwnerComp = GetOwningComponent();
+	FVector IKFootFloorLocation = OwnerComp->GetSocketLocation(IKFootBone);
+	IKFootFloorLocation.Z = OwnerComp->GetSocketLocation(RootBone).Z;
+
+	FVector ImpactPoint;
+	FVector ImpactNormal;
+	const FVector TraceStart = IKFootFloorLocation + FVector(0.f, 0.f, IKTraceDistanceAboveFoot);
+	const FVector TraceEnd = IKFootFloorLocation - FVector(0.f, 0.f, IKTraceDistanceBelowFoot);
+
+	FRotator TargetRotationOffset = FRotator::ZeroRotator;
+	if (GetFootGround(FootIndex, TraceStart, TraceEnd, ImpactPoint, ImpactNormal))
+	{
+		// Find the difference in location from the Impact point and the expected (flat) floor location.
+		// These values are offset by the normal multiplied by the foot height to get better behavior on angled surfaces.
+		Foot.OffsetTarget = (ImpactPoint + ImpactNormal * FootHeight) - (IKFootFloorLocation + FVector(0.f, 0.f, FootHeight));
+
+		// Calculate the Rotation offset by getting the Atan2 of the Impact Normal.
+		TargetRotationOffset.Roll = FMath::RadiansToDegrees(FMath::Atan2(ImpactNormal.Y, ImpactNormal.Z));
+		TargetRotationOffset.Pitch = -FMath::RadiansToDegrees(FMath::Atan2(ImpactNormal.X, ImpactNormal.Z));
+	}
+	else
+	{
+		Foot.OffsetTarget = FVector::ZeroVector;
+	}
+
+	// Interp the Current Location to the new Target value, interpolating at different speeds based on whether the new target is above or below the current one.
+	const float LocationInterpSpeed = Foot.OffsetLocation.Z > Foot.OffsetTarget.Z ? 30.f : 15.f;
+	Foot.OffsetLocation = FMath::VInterpTo(Foot.OffsetLocation, Foot.OffsetTarget, DeltaTimeX, LocationInterpSpeed);
+
+	// Interp the Current Rotation to the new Target value.
+	Foot.OffsetRotation = FMath::RInterpTo(Foot.OffsetRotation, TargetRotationOffset, DeltaTimeX, 30.f);
+}
+
+void ULSAnimInstance::SetPelvisIKOffset(const FVector& FootOffsetLTarget, const FVector& FootOffsetRTarget)
+{
+	// Calculate the Pelvis Alpha by finding the average Foot IK weight. If the alpha is 0, clear the offset.
+	PelvisAlpha = (GetCurveValue(TEXT("Enable_FootIK_L")) + GetCurveValue(TEXT("Enable_FootIK_R"))) / 2.f;
+	if (PelvisAlpha <= 0.f)
+	{
+		PelvisOffset = FVector::ZeroVector;
+		return;
+	}
+
+	// Step 1: Set the new Pelvis Target to be the lowest Foot Offset
+	const FVector PelvisTarget = FootOffsetLTarget.Z < FootOffsetRTarget.Z ? FootOffsetLTarget : FootOffsetRTarget;
+
+	// Step 2: Interp the Current Pelvis Offset to the new target value.
+	// Interpolate at different speeds based on whether the new target is above or below the current one.
+	const float InterpSpeed = PelvisTarget.Z > PelvisOffset.Z ? 10.f : 15.f;
+	PelvisOffset = FMath::VInterpTo(PelvisOffset, PelvisTarget, DeltaTimeX, InterpSpeed);
+}
+
+void ULSAnimInstance::ResetIKOffsets()
+{
+	// Interp Foot IK offsets back to 0
+	FootIK_L.OffsetLocation = FMath::VInterpTo(FootIK_L.OffsetLocation, FVector::ZeroVector, DeltaTimeX, 15.f);
+	FootIK_R.OffsetLocation = FMath::VInterpTo(FootIK_R.OffsetLocation, FVector::ZeroVector, DeltaTimeX, 15.f);
+	FootIK_L.OffsetRotation = FMath::RInterpTo(FootIK_L.OffsetRotation, FRotator::ZeroRotator, DeltaTimeX, 15.f);
+	FootIK_R.OffsetRotation = FMath::RInterpTo(FootIK_R.OffsetRotation, FRotator::ZeroRotator, DeltaTimeX, 15.f);
+}
+
+bool ULSAnimInstance::GetFootGround(int32 FootIndex, const FVector& TraceStart, const FVector& TraceEnd, FVector& OutImpactPoint, FVector& OutImpactNormal)
+{
+	FLSFootGroundCache& Ground = FootGround[FootIndex];
+
+	// Queue a new trace when the cached plane can no longer be trusted. The result is used once the scheduler got to it.
+	ULSTraceSchedulerSubsystem* TraceScheduler = GetWorld()->GetSubsystem<ULSTraceSchedulerSubsystem>();
+	if (TraceScheduler && !CanReuseFootGround(Ground) && !TraceScheduler->IsPending(Ground.PendingTrace))
+	{
+		FLSTraceRequest Request;
+		Request.Start = TraceStart;
+		Request.End = TraceEnd;
+		Request.Params = FCollisionQueryParams(SCENE_QUERY_STAT(FootIKTrace), true, Character);
+		Request.Priority = TraceScheduler->GetPriority(Character);
+		Request.Deadline = GetWorld()->GetTimeSeconds() + FootIKTraceDeadline;
+		Request.OnCompleted.BindUObject(this, &ULSAnimInstance::OnFootTraceCompleted, FootIndex);
+		Ground.PendingTrace = TraceScheduler->RequestTrace(MoveTemp(Request));
+	}
+
+	if (!Ground.bValid || !Ground.bWalkable)
+	{
+		return false;
+	}
+
+	// Intersect the foot ray with the cached ground plane instead of tracing.
+	const FVector TraceDirection = TraceEnd - TraceStart;
+	const float Denominator = FVector::DotProduct(TraceDirection, FVector(Ground.Plane));
+	if (FMath::IsNearlyZero(Denominator))
+	{
+		return false;
+	}
+
+	const float Time = -Ground.Plane.PlaneDot(TraceStart) / Denominator;
+	if (Time < 0.f || Time > 1.f)
+	{
+		return false;
+	}
+
+	OutImpactPoint = TraceStart + TraceDirection * Time;
+	OutImpactNormal = FVector(Ground.Plane);
+	return true;
+}
+
+bool ULSAnimInstance::CanReuseFootGround(const FLSFootGroundCache& Ground) const
+{
+	if (!Ground.bValid)
+	{
+		return false;
+	}
+
+	// Standing still, the ground under the feet does not change.
+	if (!MovementInfo.bIsMoving)
+	{
+		return true;
+	}
+
+	// Moving on the same flat surface, the plane is still exact.
+	const FFindFloorResult& Floor = CharacterMovementComp->CurrentFloor;
+	if (!Floor.bBlockingHit || Floor.HitResult.GetComponent() != Ground.Component.Get())
+	{
+		return false;
+	}
+
+	return FVector::DotProduct(Floor.HitResult.ImpactNormal, FVector(Ground.Plane)) >= FMath::Cos(FMath::DegreesToRadians(FootGroundReuseMaxAngle))
+		&& FMath::Abs(Ground.Plane.PlaneDot(Floor.HitResult.ImpactPoint)) <= FootGroundReuseMaxDistance;
+}
+
+void ULSAnimInstance::OnFootTraceCompleted(FLSTraceTicket Ticket, const FLSTraceResult& Result, int32 FootIndex)
+{
+	FLSFootGroundCache& Ground = FootGround[FootIndex];
+	if (Ticket != Ground.PendingTrace)
+	{
+		return;
+	}
+	Ground.PendingTrace.Reset();
+
+	// Expired requests keep the last plane and are requested again next frame.
+	if (Result.Status == ELSTraceStatus::Expired)
+	{
+		return;
+	}
+
+	if (Result.Status != ELSTraceStatus::Hit)
+	{
+		Ground.bValid = false;
+		return;
+	}
+
+	const FHitResult& Hit = Result.Hit;
+	Ground.Plane = FPlane(Hit.ImpactPoint, Hit.ImpactNormal);
+	Ground.Component = Hit.GetComponent();
+	Ground.bWalkable = CharacterMovementComp && CharacterMovementComp->IsWalkable(Hit);
+	Ground.bValid = true;
+}
+#pragma endregion
@@ -5,76 +5,13 @@
 #include "Animation/AnimInstance.h"
 #include "Characters/LSCharacterBase.h"
 #include "CoreMinimal.h"
+#include "Data/ClimbingIKSettings.h"
+#include "Data/LocomotionSnapshot.h"
 #include "Engine/EngineTypes.h"
+#include "Subsystems/LSTraceSchedulerSubsystem.h"
 
 #include "LSAnimInstance.generated.h"
 
-USTRUCT(BlueprintType)
-struct FMovementEssentialInfo
-{
-	GENERATED_BODY()
-
-	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|Essential Info")
-	FVector Velocity = FVector::ZeroVector;
-
-	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|Essential Info")
-	FVector Acceleration = FVector::ZeroVector;
-
-	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|Essential Info")
-	FVector MovementInput = FVector::ZeroVector;
-
-	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|Essential Info")
-	bool bIsMoving = false;
-
-	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|Essential Info")
-	bool bHasMovementInput = false;
-
-	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|Essential Info")
-	float Speed = 0.f;
-
-	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|Essential Info")
-	float MovementInputAmount = 0.f;
-
-	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|Essential Info")
-	FRotator AimRotation = FRotator::ZeroRotator;
-
-	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|Essential Info")
-	float AimYawRate = 0.f;
-};
-
-USTRUCT(BlueprintType)
-struct FMovementStates
-{
-	GENERATED_BODY()
-
-	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|State")
-	TEnumAsByte<enum EMovementMode> PawnMovementMode;
-
-	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|State")
-	ELSMovementState MovementState = ELSMovementState::None;
-
-	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|State")
-	ELSMovementState PrevMovementState = ELSMovementState::None;
-
-	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|State")
-	ELSMovementAction MovementAction = ELSMovementAction::None;
-
-	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|State")
-	ELSRotationMode RotationMode = ELSRotationMode::LookingDirection;
-
-	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|State")
-	ELSGaitType ActualGait = ELSGaitType::Walking;
-
-	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|State")
-	ELSStanceType ActualStance = ELSStanceType::Standing;
-
-	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|State")
-	ELSViewMode ViewMode = ELSViewMode::ThirdPerson;
-
-	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|State")
-	ELSOverlayState OverlayState = ELSOverlayState::Default;
-};
-
 /**
  * This value represents the velocity amount of the actor in each direction
  * (normalized so that diagonals equal .5 for each direction),
@@ -124,7 +61,48 @@ enum class ELSMovementDirection
 	Backward
 };
 
+/**
+ * Foot locking and foot offset values for one foot, read by the Foot IK nodes in the anim graph.
+ */
+USTRUCT(BlueprintType)
+struct FLSFootIKValues
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	float LockAlpha = 0.f;
+
+	UPROPERTY(BlueprintReadOnly)
+	FVector LockLocation = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly)
+	FRotator LockRotation = FRotator::ZeroRotator;
+
+	UPROPERTY(BlueprintReadOnly)
+	FVector OffsetLocation = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly)
+	FRotator OffsetRotation = FRotator::ZeroRotator;
+
+	FVector OffsetTarget = FVector::ZeroVector;
+};
+
+/**
+ * Ground under one foot. Filled by async traces and reused as a plane
+ * while the character stands still or keeps moving on the same flat surface.
+ */
+struct FLSFootGroundCache
+{
+	FPlane Plane = FPlane(ForceInit);
+	TWeakObjectPtr<const UPrimitiveComponent> Component;
+	FLSTraceTicket PendingTrace;
+	bool bValid = false;
+	bool bWalkable = false;
+};
+
 class UCurveFloat;
+class ULSTurnInPlaceSet;
+struct FLSTurnInPlaceTable;
 /**
  *
  */
@@ -135,6 +113,16 @@ class LOCOMOTIONSYSTEM_API ULSAnimInstance : public UAnimInstance
 public:
 	virtual void NativeInitializeAnimation() override;
 	virtual void NativeUpdateAnimation(float DeltaSeconds) override;
+	virtual void NativeThreadSafeUpdateAnimation(float DeltaSeconds) override;
+
+	// Reset all locomotion values to their defaults, used when a pooled character is handed out again.
+	void ResetLocomotionValues();
+
+	// Set by the animation budget allocator while this mesh is over budget.
+	void SetReducedWork(bool bInReducedWork)
+	{
+		bReducedWork = bInReducedWork;
+	}
 
 #pragma region Helpers
 
@@ -147,19 +135,159 @@ public:
 
 #pragma region Aiming
 protected:
-	FRotator SmoothedAimingRotation;
-	FRotator SpineRotation;
-	FVector2D AimingAngle;
-	FVector2D SmoothedAimingAngle;
-	float AimSweepTime;
-	float InputYawTime;
-	float ForwardYawTime;
-	float LeftTawTime;
-	float RightYawTime;
+	// Runs on the worker thread from the values captured in NativeUpdateAnimation.
+	void UpdateAimingValues(float DeltaSeconds);
+
+	// Velocity Direction only needs the aiming values while the character looks around, or while the smoothing is still settling.
+	bool ShouldUpdateAimingValues() const;
+
+protected:
+	FRotator SmoothedAimingRotation = FRotator::ZeroRotator;
+	FRotator SpineRotation = FRotator::ZeroRotator;
+	FVector2D AimingAngle = FVector2D::ZeroVector;
+	FVector2D SmoothedAimingAngle = FVector2D::ZeroVector;
+	float AimSweepTime = 0.5f;
+	float InputYawTime = 0.f;
+	float ForwardYawTime = 0.f;
+	float LeftTawTime = 0.f;
+	float RightYawTime = 0.f;
+
+	// Captured on the game thread for the thread safe update.
+	FRotator CharacterRotation = FRotator::ZeroRotator;
+	double LastAimingCharacterYaw = 0.0;
+	double LastAimingPitch = 0.0;
 #pragma endregion
 
 #pragma region Grounded
+public:
+	// Yaw the active turn in place animation rotated through since the last call, scaled to the requested turn.
+	// Sampled from the turn table at the montage time, so it does not depend on the pose having been evaluated.
+	bool ConsumeTurnInPlaceYaw(float& OutYaw);
+
+protected:
+	bool CanTurnInPlace() const;
+
+	void TurnInPlaceCheck(float DeltaSeconds);
+
+	void TurnInPlace(const FRotator& TargetRotation, float PlayRateScale, float StartTime, bool bOverrideCurrent);
+
+protected:
+	struct FActiveTurnInPlace
+	{
+		TWeakObjectPtr<UAnimMontage> Montage;
+		const FLSTurnInPlaceTable* Table = nullptr;
+		float RotationScale = 1.f;
+		float LastPosition = 0.f;
+	};
+
+	FActiveTurnInPlace ActiveTurn;
+	float ElapsedDelayTime = 0.f;
+#pragma endregion
+
+#pragma region In Air
+protected:
+	void UpdateInAirValues();
+
+	// Blend weight for the landing pose, ramping up as the predicted touchdown approaches.
+	// Taken from the character's landing prediction instead of tracing here every frame.
+	float CalculateLandPrediction() const;
+
+protected:
+	UPROPERTY(BlueprintReadOnly, Category = "In Air")
+	float FallSpeed = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "In Air")
+	float LandPrediction = 1.f;
+
+	FLSLandingPrediction LandingPrediction;
+#pragma endregion
+
+#pragma region Locomotion Events
+protected:
+	// Drain the character's event queue and turn jumps and landings into short pulses the anim graph can transition on.
+	// Runs in the thread safe update, the character pushes the events from the game thread.
+	void ProcessLocomotionEvents(float DeltaSeconds);
+
+protected:
+	UPROPERTY(BlueprintReadOnly, Category = "Locomotion Events")
+	bool bJumped = false;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Locomotion Events")
+	float JumpPlayRate = 1.2f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Locomotion Events")
+	bool bLanded = false;
 
+	// Falling speed of the last landing.
+	UPROPERTY(BlueprintReadOnly, Category = "Locomotion Events")
+	float LandSpeed = 0.f;
+
+	float JumpedTimeRemaining = 0.f;
+	float LandedTimeRemaining = 0.f;
+
+	TSharedPtr<FLSLocomotionEventQueue, ESPMode::ThreadSafe> LocomotionEvents;
+#pragma endregion
+
+#pragma region Foot IK
+protected:
+	void UpdateFootIK();
+
+	void SetFootLocking(const FName& EnableFootIKCurve, const FName& FootLockCurve, const FName& IKFootBone, FLSFootIKValues& Foot);
+
+	// Keep the locked foot planted in place while the capsule moves or rotates.
+	void SetFootLockOffsets(FLSFootIKValues& Foot);
+
+	void SetFootOffsets(const FName& EnableFootIKCurve, const FName& IKFootBone, int32 FootIndex, FLSFootIKValues& Foot);
+
+	void SetPelvisIKOffset(const FVector& FootOffsetLTarget, const FVector& FootOffsetRTarget);
+
+	void ResetIKOffsets();
+
+	// Find the ground under the foot from the cached plane or the last async trace, and queue a new trace if the cache is stale.
+	bool GetFootGround(int32 FootIndex, const FVector& TraceStart, const FVector& TraceEnd, FVector& OutImpactPoint, FVector& OutImpactNormal);
+
+	bool CanReuseFootGround(const FLSFootGroundCache& Ground) const;
+
+	void OnFootTraceCompleted(FLSTraceTicket Ticket, const FLSTraceResult& Result, int32 FootIndex);
+
+protected:
+	UPROPERTY(BlueprintReadOnly, Category = "Foot IK")
+	FLSFootIKValues FootIK_L;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Foot IK")
+	FLSFootIKValues FootIK_R;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Foot IK")
+	FVector PelvisOffset = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Foot IK")
+	float PelvisAlpha = 0.f;
+
+	FLSFootGroundCache FootGround[2];
+#pragma endregion
+
+#pragma region Climbing IK
+protected:
+	// Copy the limb targets the climbing IK subsystem traced for the character, on the game thread.
+	void CopyClimbingLimbTargets();
+
+	// Runs on the worker thread, blending the limbs towards the copied targets.
+	void UpdateClimbingIK(float DeltaSeconds);
+
+protected:
+	UPROPERTY(BlueprintReadOnly, Category = "Climbing IK")
+	FLSClimbingLimbTarget ClimbingHandL;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Climbing IK")
+	FLSClimbingLimbTarget ClimbingHandR;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Climbing IK")
+	FLSClimbingLimbTarget ClimbingFootL;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Climbing IK")
+	FLSClimbingLimbTarget ClimbingFootR;
+
+	FLSClimbingLimbTargets ClimbingLimbTargets;
 #pragma endregion
 
 #pragma region Movement
@@ -188,10 +316,15 @@ protected:
 
 protected:
 	FVelocityBlend VelocityBlend;
+	FVelocityBlend VelocityBlendTarget;
 	float StrideBlend = 0.f;
 	float StandingPlayRate = 1.f;
 	float WalkRunBlend = 0.f;
 	float CrouchingPlayRate = 1.f;
+
+	// Under a reduced budget the movement targets are only recalculated every few updates.
+	bool bReducedWork = false;
+	int32 UpdatesSinceMovementValues = 0;
 #pragma endregion
 
 protected:
@@ -203,6 +336,9 @@ protected:
 
 	float DeltaTimeX = 0.f;
 
+	// Set on the game thread, so the thread safe update never touches the character.
+	bool bHasCharacter = false;
+
 	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|Essential Info")
 	FMovementEssentialInfo MovementInfo;
 
@@ -224,6 +360,71 @@ protected:
 
 	UPROPERTY(EditDefaultsOnly, Category = "Config")
 	float VelocityBlendInterpSpeed = 12.f;
+
+	// While the animation budget reduces work, the velocity blend, stride and play rates are recalculated once per this many updates.
+	UPROPERTY(EditDefaultsOnly, Category = "Config")
+	int32 ReducedWorkMovementUpdateInterval = 3;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Config|Turn In Place")
+	TObjectPtr<ULSTurnInPlaceSet> TurnInPlaceSet;
+
+	// Maps the normalized time to land (0 touching down, 1 at Land Prediction Time or further) to the land pose weight.
+	UPROPERTY(EditDefaultsOnly, Category = "Config|In Air")
+	TObjectPtr<UCurveFloat> LandPredictionCurve;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Config|In Air")
+	float LandPredictionTime = 0.5f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Config|Aiming")
+	float SmoothedAimingRotationInterpSpeed = 10.f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Config|Aiming")
+	float InputYawOffsetInterpSpeed = 8.f;
+
+	// In Velocity Direction the aiming update is skipped while the aim yaw rate stays below this, in degrees per second.
+	UPROPERTY(EditDefaultsOnly, Category = "Config|Aiming")
+	float LookingAroundMinAimYawRate = 5.f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Config|Climbing IK")
+	float ClimbingIKInterpSpeed = 15.f;
+
+	// How long the Jumped and Landed pulses stay set.
+	UPROPERTY(EditDefaultsOnly, Category = "Config|Locomotion Events")
+	float LocomotionEventPulseDuration = 0.1f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Config|Foot IK")
+	float IKTraceDistanceAboveFoot = 50.f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Config|Foot IK")
+	float IKTraceDistanceBelowFoot = 45.f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Config|Foot IK")
+	float FootHeight = 13.5f;
+
+	// Foot traces the trace scheduler could not fit into its budget for this long are dropped and requested again.
+	UPROPERTY(EditDefaultsOnly, Category = "Config|Foot IK")
+	float FootIKTraceDeadline = 0.1f;
+
+	// Foot IK traces are skipped entirely above this mesh LOD and the offsets blend out.
+	UPROPERTY(EditDefaultsOnly, Category = "Config|Foot IK")
+	int32 FootIKMaxLOD = 1;
+
+	// The cached ground plane is trusted while the floor normal stays within this angle of it.
+	UPROPERTY(EditDefaultsOnly, Category = "Config|Foot IK")
+	float FootGroundReuseMaxAngle = 2.f;
+
+	// ...and the floor under the capsule stays within this distance of it, which catches steps on the same mesh.
+	UPROPERTY(EditDefaultsOnly, Category = "Config|Foot IK")
+	float FootGroundReuseMaxDistance = 2.f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Config|Foot IK")
+	FName IKFootLBone = TEXT("ik_foot_l");
+
+	UPROPERTY(EditDefaultsOnly, Category = "Config|Foot IK")
+	FName IKFootRBone = TEXT("ik_foot_r");
+
+	UPROPERTY(EditDefaultsOnly, Category = "Config|Foot IK")
+	FName RootBone = TEXT("root");
 #pragma endregion
 
 #pragma region Blend Curves
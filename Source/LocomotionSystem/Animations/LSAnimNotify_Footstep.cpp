@@ -0,0 +1,40 @@
+// Copyright BanMing
+
+#include "Animations/LSAnimNotify_Footstep.h"
+
+#include "Animation/AnimInstance.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "Subsystems/LSFootstepSubsystem.h"
+
+void ULSAnimNotify_Footstep::Notify(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, const FAnimNotifyEventReference& EventReference)
+{
+	Super::Notify(MeshComp, Animation, EventReference);
+
+	UWorld* World = MeshComp ? MeshComp->GetWorld() : nullptr;
+	ULSFootstepSubsystem* FootstepSubsystem = World ? World->GetSubsystem<ULSFootstepSubsystem>() : nullptr;
+	if (FootstepSubsystem == nullptr)
+	{
+		return;
+	}
+
+	FLSFootstepRequest Request;
+	Request.SurfaceTable = SurfaceTable;
+	Request.Instigator = MeshComp->GetOwner();
+	Request.FootLocation = MeshComp->GetSocketLocation(FootSocket);
+	Request.FootstepType = static_cast<int32>(FootstepType);
+	Request.VolumeMultiplier = VolumeMultiplier;
+	Request.PitchMultiplier = PitchMultiplier;
+	Request.bSpawnDecal = bSpawnDecal;
+
+	// The Mask_FootstepSound curve mutes footsteps of animations that are blending out.
+	const UAnimInstance* AnimInstance = MeshComp->GetAnimInstance();
+	Request.bPlaySound = bOverrideMaskCurve || AnimInstance == nullptr || AnimInstance->GetCurveValue(TEXT("Mask_FootstepSound")) <= 0.f;
+
+	FootstepSubsystem->PlayFootstep(Request);
+}
+
+FString ULSAnimNotify_Footstep::GetNotifyName_Implementation() const
+{
+	return FString::Printf(TEXT("Footstep: %s"), *UEnum::GetDisplayValueAsText(FootstepType).ToString());
+}
@@ -0,0 +1,53 @@
+// Copyright BanMing
+
+#pragma once
+
+#include "Animation/AnimNotifies/AnimNotify.h"
+#include "CoreMinimal.h"
+
+#include "LSAnimNotify_Footstep.generated.h"
+
+UENUM(BlueprintType)
+enum class ELSFootstepType : uint8
+{
+	Step,
+	Walk,
+	Jump,
+	Land
+};
+
+/**
+ * Plays a surface dependent footstep sound and decal through the pooled footstep subsystem.
+ */
+UCLASS(meta = (DisplayName = "LS Footstep"))
+class LOCOMOTIONSYSTEM_API ULSAnimNotify_Footstep : public UAnimNotify
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Notify(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, const FAnimNotifyEventReference& EventReference) override;
+	virtual FString GetNotifyName_Implementation() const override;
+
+protected:
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Footstep")
+	TObjectPtr<class ULSFootstepSurfaceTable> SurfaceTable;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Footstep")
+	FName FootSocket = TEXT("Root");
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Footstep")
+	ELSFootstepType FootstepType = ELSFootstepType::Step;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Footstep")
+	float VolumeMultiplier = 1.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Footstep")
+	float PitchMultiplier = 1.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Footstep")
+	bool bSpawnDecal = false;
+
+	// Play the footstep even while the Mask_FootstepSound curve is active.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Footstep")
+	bool bOverrideMaskCurve = false;
+};
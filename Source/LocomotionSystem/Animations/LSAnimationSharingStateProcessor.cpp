@@ -0,0 +1,75 @@
+// Copyright BanMing
+
+#include "Animations/LSAnimationSharingStateProcessor.h"
+
+#include "Characters/LSCharacterBase.h"
+#include "Data/AnimationSharingStates.h"
+
+// Grounded states per overlay style, see ELSAnimationSharingState.
+static constexpr int32 NumGroundedSharingStates = 6;
+
+void ULSAnimationSharingStateProcessor::ProcessActorState_Implementation(int32& OutState, AActor* InActor, uint8 CurrentState, uint8 OnDemandState, bool& bShouldProcess)
+{
+	const ALSCharacterBase* Character = Cast<ALSCharacterBase>(InActor);
+	if (Character == nullptr)
+	{
+		bShouldProcess = false;
+		return;
+	}
+
+	const FLSLocomotionSnapshot& Snapshot = Character->GetLocomotionSnapshot().GetLatest();
+	const FMovementStates& States = Snapshot.MovementStates;
+
+	ELSAnimationSharingState State;
+	switch (States.MovementState)
+	{
+		case ELSMovementState::InAir:
+			State = ELSAnimationSharingState::InAir;
+			break;
+		case ELSMovementState::Mantling:
+			State = ELSAnimationSharingState::Mantling;
+			break;
+		case ELSMovementState::Climbing:
+			State = ELSAnimationSharingState::Climbing;
+			break;
+		case ELSMovementState::Grounded:
+		{
+			const FMovementEssentialInfo& Info = Snapshot.MovementInfo;
+
+			int32 Locomotion = 0;
+			if (States.ActualStance == ELSStanceType::Crouching)
+			{
+				Locomotion = Info.bIsMoving ? 5 : 4;
+			}
+			else if (Info.bIsMoving)
+			{
+				Locomotion = 1 + static_cast<int32>(States.ActualGait);
+			}
+
+			int32 Style = 0;
+			if (States.OverlayState == ELSOverlayState::Masculine)
+			{
+				Style = 1;
+			}
+			else if (States.OverlayState == ELSOverlayState::Feminine)
+			{
+				Style = 2;
+			}
+
+			State = static_cast<ELSAnimationSharingState>(Style * NumGroundedSharingStates + Locomotion);
+			break;
+		}
+		default:
+			// Ragdolls and unset states keep what they had.
+			bShouldProcess = false;
+			return;
+	}
+
+	OutState = static_cast<int32>(State);
+	bShouldProcess = true;
+}
+
+UEnum* ULSAnimationSharingStateProcessor::GetAnimationStateEnum_Implementation()
+{
+	return StaticEnum<ELSAnimationSharingState>();
+}
@@ -0,0 +1,22 @@
+// Copyright BanMing
+
+#pragma once
+
+#include "AnimationSharingTypes.h"
+#include "CoreMinimal.h"
+
+#include "LSAnimationSharingStateProcessor.generated.h"
+
+/**
+ * Picks the ELSAnimationSharingState an LS character follows while it uses a shared pose.
+ * State changes are blended by the Animation Sharing Manager with the blend time of the target state in the setup.
+ */
+UCLASS()
+class LOCOMOTIONSYSTEM_API ULSAnimationSharingStateProcessor : public UAnimationSharingStateProcessor
+{
+	GENERATED_BODY()
+
+public:
+	virtual void ProcessActorState_Implementation(int32& OutState, AActor* InActor, uint8 CurrentState, uint8 OnDemandState, bool& bShouldProcess) override;
+	virtual UEnum* GetAnimationStateEnum_Implementation() override;
+};
@@ -3,14 +3,52 @@
 #include "LSCharacterBase.h"
 
 #include "Animation/AnimInstance.h"
+#include "Animation/AnimMontage.h"
+#include "AnimationSharingManager.h"
+#include "AnimationSharingSetup.h"
 #include "Animations/LSAnimInstance.h"
 #include "Characters/LSCharacter.h"
 #include "Components/CapsuleComponent.h"
+#include "Components/LSCharacterMovementComponent.h"
+#include "Components/LSRootMotionSource_Mantle.h"
 #include "Curves/CurveFloat.h"
 #include "Curves/CurveVector.h"
+#include "Data/ActionMontageSet.h"
+#include "Data/LocomotionRecording.h"
+#include "Data/LocomotionRules.h"
+#include "Data/OverlayLayerSet.h"
+#include "Engine/AssetManager.h"
+#include "Engine/Engine.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/PlayerController.h"
 #include "Kismet/GameplayStatics.h"
 #include "Kismet/KismetMathLibrary.h"
+#include "LocomotionSystem.h"
+#include "Mass/LSMassFragments.h"
+#include "SkeletalMeshComponentBudgeted.h"
+#include "Subsystems/LSAvoidanceSubsystem.h"
+#include "Subsystems/LSClimbingIKSubsystem.h"
+#include "Subsystems/LSLagCompensationSubsystem.h"
+#include "Subsystems/LSMassLODSubsystem.h"
+#include "Subsystems/LSOverlayLayerSubsystem.h"
+#include "Subsystems/LSTraceSchedulerSubsystem.h"
+
+ALSCharacterBase::ALSCharacterBase(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<ULSCharacterMovementComponent>(ACharacter::CharacterMovementComponentName)
+				.SetDefaultSubobjectClass<USkeletalMeshComponentBudgeted>(ACharacter::MeshComponentName))
+{
+	LSMovementComponent = Cast<ULSCharacterMovementComponent>(GetCharacterMovement());
+
+	// Registered with the animation budget allocator on BeginPlay, the significance is pushed from Tick.
+	if (USkeletalMeshComponentBudgeted* BudgetedMesh = Cast<USkeletalMeshComponentBudgeted>(GetMesh()))
+	{
+		BudgetedMesh->SetAutoRegisterWithBudgetAllocator(true);
+		BudgetedMesh->SetAutoCalculateSignificance(false);
+	}
+
+	FallingMantleTraceSettings.MaxLedgeHeight = 150.f;
+	FallingMantleTraceSettings.ReachDistance = 70.f;
+}
 
 void ALSCharacterBase::BeginPlay()
 {
@@ -18,33 +56,50 @@ void ALSCharacterBase::BeginPlay()
 	OnBeginPlay();
 }
 
+void ALSCharacterBase::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	ReleaseOverlayLayers();
+	SetClimbingIKRegistered(false);
+	StopSharedAnimation();
+	if (ULSMassLODSubsystem* MassLODSubsystem = GetWorld()->GetSubsystem<ULSMassLODSubsystem>())
+	{
+		MassLODSubsystem->UnregisterCharacter(this);
+	}
+	if (ULSAvoidanceSubsystem* AvoidanceSubsystem = GetWorld()->GetSubsystem<ULSAvoidanceSubsystem>())
+	{
+		AvoidanceSubsystem->UnregisterCharacter(this);
+	}
+	if (ULSLagCompensationSubsystem* LagCompensationSubsystem = GetWorld()->GetSubsystem<ULSLagCompensationSubsystem>())
+	{
+		LagCompensationSubsystem->UnregisterCharacter(this);
+	}
+	PreloadedActionMontages.Empty();
+	Super::EndPlay(EndPlayReason);
+}
+
 void ALSCharacterBase::Tick(float DeltaSeconds)
 {
 	Super::Tick(DeltaSeconds);
-	SetEssentialValues();
 
-	// Check Movement Mode
-	if (MovementState == ELSMovementState::Grounded)
+	if (bUseFixedStep)
 	{
-		UpdateCharacterMovement();
-		UpdateGroundedRotation();
+		UpdateFixedStepLocomotion(DeltaSeconds);
 	}
-	else if (MovementState == ELSMovementState::InAir)
+	else
 	{
-		UpdateInAirRotation();
-
-		// Perform a mantle check if falling while movement input is pressed.
-		if (bHasMovementInput)
-		{
-			// TODO MantleCheck()
-		}
+		const float FrameDeltaTime = UGameplayStatics::GetWorldDeltaSeconds(this);
+		UpdateLocomotion(FrameDeltaTime, FrameDeltaTime, 1);
 	}
-	else if (MovementState == ELSMovementState::Ragdoll)
+
+	// Nothing is animated for show on a dedicated server.
+	if (GetNetMode() != NM_DedicatedServer)
 	{
-		// TODO RagdollUpdate()
+		const float ClosestViewDistance = GetClosestViewDistance();
+		UpdateAnimationSharing(ClosestViewDistance);
+		UpdateAnimationSignificance(ClosestViewDistance);
 	}
 
-	CacheValues();
+	PublishLocomotionSnapshot();
 }
 
 #pragma region Input
@@ -64,18 +119,33 @@ void ALSCharacterBase::PlayerMovementInput(bool IsForwardAxis)
 	const float MoveForward = FMath::Clamp(InputForward * InputRightRange, -1.f, 1.f);
 	const float MoveRight = FMath::Clamp(InputRight * InputForwardRange, -1.f, 1.f);
 
+	FVector Forward;
+	FVector Right;
+	GetMovementInputAxes(Forward, Right);
 	if (IsForwardAxis)
 	{
-		FVector Forward = UKismetMathLibrary::GetForwardVector(GetControlRotation());
 		AddMovementInput(Forward, MoveForward);
 	}
 	else
 	{
-		FVector Right = UKismetMathLibrary::GetRightVector(GetControlRotation());
 		AddMovementInput(Right, MoveRight);
 	}
 }
 
+void ALSCharacterBase::GetMovementInputAxes(FVector& OutForward, FVector& OutRight) const
+{
+	// While climbing, forward input moves up the surface and right input along it.
+	if (MovementState == ELSMovementState::Climbing && LSMovementComponent)
+	{
+		OutForward = LSMovementComponent->GetClimbUpVector();
+		OutRight = LSMovementComponent->GetClimbRightVector();
+		return;
+	}
+
+	OutForward = UKismetMathLibrary::GetForwardVector(GetControlRotation());
+	OutRight = UKismetMathLibrary::GetRightVector(GetControlRotation());
+}
+
 FVector ALSCharacterBase::GetPlayerMovementInput()
 {
 	FVector MovementInput = FVector::ZeroVector;
@@ -140,12 +210,12 @@ void ALSCharacterBase::SetEssentialValues()
 
 	// Set the Aim Yaw rate by comparing the current and previous Aim Yaw value, divided by Delta Seconds.
 	// This represents the speed the camera is rotating left to right.
-	AimYawRate = FMath::Abs((GetControlRotation().Yaw - PreviousAimYaw) / UGameplayStatics::GetWorldDeltaSeconds(this));
+	AimYawRate = FMath::Abs((GetControlRotation().Yaw - PreviousAimYaw) / LocomotionDeltaTime);
 }
 
 FVector ALSCharacterBase::CalculateAcceleration()
 {
-	return (GetVelocity() - PreviousVelocity) / UGameplayStatics::GetWorldDeltaSeconds(this);
+	return (GetVelocity() - PreviousVelocity) / LocomotionDeltaTime;
 }
 
 void ALSCharacterBase::CacheValues()
@@ -156,6 +226,148 @@ void ALSCharacterBase::CacheValues()
 
 #pragma endregion
 
+#pragma region Locomotion Snapshot
+
+void ALSCharacterBase::PublishLocomotionSnapshot()
+{
+	FLSLocomotionSnapshot& Snapshot = LocomotionSnapshot.BeginWrite();
+	GetMovementInfo(Snapshot.MovementInfo);
+	GetMovementStates(Snapshot.MovementStates);
+	Snapshot.ActorRotation = GetActorRotation();
+	Snapshot.FrameNumber = GFrameCounter;
+	LocomotionSnapshot.Publish();
+}
+
+#pragma endregion
+
+#pragma region Locomotion Events
+
+void ALSCharacterBase::PushLocomotionEvent(ELSLocomotionEventType Type, uint8 PreviousValue, uint8 NewValue, float EventSpeed)
+{
+	FLSLocomotionEvent Event;
+	Event.Type = Type;
+	Event.PreviousValue = PreviousValue;
+	Event.NewValue = NewValue;
+	Event.Speed = EventSpeed;
+	Event.FrameNumber = GFrameCounter;
+	LocomotionEvents.Push(Event);
+}
+
+#pragma endregion
+
+#pragma region Fixed Step
+
+void ALSCharacterBase::UpdateLocomotion(float SampleDeltaTime, float StepDeltaTime, int32 NumSteps)
+{
+	LocomotionDeltaTime = SampleDeltaTime;
+	SetEssentialValues();
+
+	LocomotionDeltaTime = StepDeltaTime;
+
+	// Check Movement Mode
+	if (MovementState == ELSMovementState::Grounded)
+	{
+		UpdateCharacterMovement();
+		for (int32 Step = 0; Step < NumSteps; ++Step)
+		{
+			UpdateGroundedRotation();
+		}
+	}
+	else if (MovementState == ELSMovementState::InAir)
+	{
+		for (int32 Step = 0; Step < NumSteps; ++Step)
+		{
+			UpdateInAirRotation();
+		}
+		UpdateLandingPrediction();
+
+		// Perform a mantle check if falling while movement input is pressed.
+		if (bHasMovementInput)
+		{
+			RequestMantle();
+		}
+	}
+	else if (MovementState == ELSMovementState::Climbing)
+	{
+		UpdateClimbing();
+	}
+	else if (MovementState == ELSMovementState::Ragdoll)
+	{
+		// TODO RagdollUpdate()
+	}
+
+	CacheValues();
+}
+
+void ALSCharacterBase::UpdateFixedStepLocomotion(float DeltaSeconds)
+{
+	// Mantling, teleports and the like rotate the actor directly, continue the steps from there.
+	if (!GetActorRotation().Equals(CurrentStepRotation))
+	{
+		PreviousStepRotation = GetActorRotation();
+		CurrentStepRotation = GetActorRotation();
+	}
+
+	const float StepDeltaTime = 1.f / FMath::Max(FixedStepRate, 1.f);
+	FixedStepAccumulator += DeltaSeconds;
+	TimeSinceEssentialValues += DeltaSeconds;
+
+	int32 NumSteps = FMath::FloorToInt32(FixedStepAccumulator / StepDeltaTime);
+	if (NumSteps > MaxFixedSteps)
+	{
+		NumSteps = FMath::Max(MaxFixedSteps, 1);
+		FixedStepAccumulator = NumSteps * StepDeltaTime;
+	}
+
+	if (NumSteps > 0)
+	{
+		PreviousStepRotation = CurrentStepRotation;
+
+		// The velocity and aim yaw deltas span the real time since they were last sampled, frames without a step and dropped time included.
+		UpdateLocomotion(TimeSinceEssentialValues, StepDeltaTime, NumSteps);
+		TimeSinceEssentialValues = 0.f;
+		FixedStepAccumulator -= NumSteps * StepDeltaTime;
+
+		// Interpolate over the last step only, longer frames would lag behind otherwise.
+		if (NumSteps > 1)
+		{
+			PreviousStepRotation = FMath::Lerp(PreviousStepRotation, GetActorRotation(), static_cast<float>(NumSteps - 1) / NumSteps);
+		}
+		CurrentStepRotation = GetActorRotation();
+	}
+
+	// The actor stays on the last step, which is what movement, gameplay and replication use. Only the mesh shows the interpolated rotation.
+	const float Alpha = FMath::Clamp(FixedStepAccumulator / StepDeltaTime, 0.f, 1.f);
+	const FQuat PresentedRotation = FQuat::Slerp(PreviousStepRotation.Quaternion(), CurrentStepRotation.Quaternion(), Alpha);
+	SetMeshPresentedRotation(PresentedRotation);
+}
+
+void ALSCharacterBase::SetMeshPresentedRotation(const FQuat& PresentedRotation)
+{
+	// Network smoothing owns the mesh offset of simulated proxies.
+	if (GetMesh() == nullptr || GetLocalRole() == ROLE_SimulatedProxy)
+	{
+		return;
+	}
+
+	const FQuat RelativeRotation = GetActorQuat().Inverse() * PresentedRotation * GetBaseRotationOffset();
+	GetMesh()->SetRelativeRotation(RelativeRotation);
+}
+
+void ALSCharacterBase::ResetFixedStep()
+{
+	FixedStepAccumulator = 0.f;
+	TimeSinceEssentialValues = 0.f;
+	PreviousStepRotation = GetActorRotation();
+	CurrentStepRotation = GetActorRotation();
+	if (bUseFixedStep)
+	{
+		SetMeshPresentedRotation(GetActorQuat());
+	}
+}
+
+#pragma endregion
+
 #pragma region Movement State Events
 
 void ALSCharacterBase::OnMovementModeChanged(EMovementMode PrevMovementMode, uint8 PreviousCustomMode)
@@ -179,25 +391,42 @@ void ALSCharacterBase::OnEndCrouch(float HalfHeightAdjust, float ScaledHalfHeigh
 void ALSCharacterBase::Landed(const FHitResult& Hit)
 {
 	Super::Landed(Hit);
-	// TODO On Landed: Temporarily increase the braking friction on lands to make landings more accurate, or trigger a breakfall roll.
-	// if (bBreakFall)
-	//{
-	//	BreakfallEvent();
-	// }
-	// else
-	//{
-	//	GetCharacterMovement()->BrakingFrictionFactor = bHasMovementInput ? 0.5f : 3.f;
-	//	UKismetSystemLibrary::RetriggerableDelay(this, 0.5f);
-	//	GetCharacterMovement()->BrakingFrictionFactor = 0.f;
-	// }
+	PushLocomotionEvent(ELSLocomotionEventType::Landed, 0, 0, FMath::Abs(GetVelocity().Z));
+
+	// Temporarily increase the braking friction on lands to make landings more accurate, or trigger a breakfall roll.
+	// Both are normally decided ahead of time by the landing prediction, only an unpredicted landing decides here.
+	if (!bLandingScheduled)
+	{
+		bLandingBreakfall = bBreakFall;
+		LandingBrakingFriction = bHasMovementInput ? 0.5f : 3.f;
+	}
+
+	if (bLandingBreakfall)
+	{
+		BreakfallEvent();
+	}
+	else if (LSMovementComponent)
+	{
+		// Restored by the movement component during its move tick.
+		LSMovementComponent->StartLandingFriction(LandingBrakingFriction, 0.5f);
+	}
+
+	ResetLandingPrediction();
 }
 
 void ALSCharacterBase::BreakfallEvent()
 {
-	// TODO Breakfall: Simply play a Root Motion Montage.
-	if (IsValid(MainAnimInstance))
+	// Breakfall: Simply play a Root Motion Montage. The roll lasts as long as the montage, timed by the movement component.
+	UAnimMontage* RollMontage = GetRollAnimation();
+	if (IsValid(MainAnimInstance) && RollMontage)
 	{
-		// MainAnimInstance->Montage_Play();
+		const float PlayRate = 1.35f;
+		MainAnimInstance->Montage_Play(RollMontage, PlayRate);
+		OnMovementActionChanged(ELSMovementAction::Rolling);
+		if (LSMovementComponent)
+		{
+			LSMovementComponent->StartTimedAction(ELSMovementAction::Rolling, RollMontage->GetPlayLength() / PlayRate);
+		}
 	}
 }
 
@@ -207,10 +436,7 @@ void ALSCharacterBase::OnJumped_Implementation()
 	// On Jumped : Set the new In Air Rotation to the velocity rotation if speed is greater than 100.
 	InAirRotation = Speed > 100.f ? LastVelocityRotation : GetActorRotation();
 
-	if (IsValid(MainAnimInstance))
-	{
-		// MainAnimInstance->Jumped();
-	}
+	PushLocomotionEvent(ELSLocomotionEventType::Jumped, 0, 0, Speed);
 }
 
 #pragma endregion
@@ -233,21 +459,67 @@ void ALSCharacterBase::GetMovementStates(FMovementStates& OutMovementStates) con
 void ALSCharacterBase::OnBeginPlay()
 {
 	check(GetMesh());
-	// Make sure the mesh and animbp update after the MovementComponent to ensure it gets the most recent values.
-
+	// Make sure the mesh and animbp update after the character has published this frame's locomotion snapshot.
 	GetMesh()->AddTickPrerequisiteActor(this);
 
 	// Set Reference to the Main Anim Instance.
 	MainAnimInstance = GetMesh()->GetAnimInstance();
 
+	if (LSMovementComponent)
+	{
+		LSMovementComponent->OnTimedActionEnded.BindUObject(this, &ALSCharacterBase::OnTimedActionEnded);
+		LSMovementComponent->OnMantleRequested.BindUObject(this, &ALSCharacterBase::OnMantleRequested);
+	}
+
+	if (USkeletalMeshComponentBudgeted* BudgetedMesh = Cast<USkeletalMeshComponentBudgeted>(GetMesh()))
+	{
+		BudgetedMesh->OnReduceWork().BindUObject(this, &ALSCharacterBase::OnAnimationReduceWork);
+	}
+
+	if (bAllowMassLOD)
+	{
+		if (ULSMassLODSubsystem* MassLODSubsystem = GetWorld()->GetSubsystem<ULSMassLODSubsystem>())
+		{
+			MassLODSubsystem->RegisterCharacter(this);
+		}
+	}
+
+	if (bUseLSAvoidance)
+	{
+		if (ULSAvoidanceSubsystem* AvoidanceSubsystem = GetWorld()->GetSubsystem<ULSAvoidanceSubsystem>())
+		{
+			AvoidanceSubsystem->RegisterCharacter(this);
+		}
+
+		// Path following has to go through the movement input for the steering to add to it.
+		GetCharacterMovement()->bUseAccelerationForPaths = true;
+	}
+
+	// Only exists on servers.
+	if (ULSLagCompensationSubsystem* LagCompensationSubsystem = GetWorld()->GetSubsystem<ULSLagCompensationSubsystem>())
+	{
+		LagCompensationSubsystem->RegisterCharacter(this);
+	}
+
 	// Set the Movement Model
 	SetMovementModel();
 
-	// Update states to use the initial desired values.
+	ApplyDesiredStates();
+
+	// Set default rotation values.
+	TargetRotation = GetActorRotation();
+	LastVelocityRotation = GetActorRotation();
+	LastMovementInputRotation = GetActorRotation();
+	ResetFixedStep();
+}
+
+void ALSCharacterBase::ApplyDesiredStates()
+{
 	OnGaitChanged(DesiredGait);
 	OnRotationModeChanged(DesiredRotationMode);
 	OnViewModeChanged(ViewMode);
 	OnOverlayStateChanged(OverlayState);
+	UpdateOverlayLayer();
 	if (DesiredStance == ELSStanceType::Standing)
 	{
 		UnCrouch();
@@ -256,11 +528,72 @@ void ALSCharacterBase::OnBeginPlay()
 	{
 		Crouch();
 	}
+}
 
-	// Set default rotation values.
+void ALSCharacterBase::ResetLocomotionState()
+{
+	const ALSCharacterBase* Defaults = GetClass()->GetDefaultObject<ALSCharacterBase>();
+
+	// Input
+	DesiredRotationMode = Defaults->DesiredRotationMode;
+	DesiredGait = Defaults->DesiredGait;
+	DesiredStance = Defaults->DesiredStance;
+	TimesPressedStance = Defaults->TimesPressedStance;
+	bBreakFall = Defaults->bBreakFall;
+	bSprintHeld = Defaults->bSprintHeld;
+
+	// States
+	SetClimbingIKRegistered(false);
+	StopSharedAnimation();
+	MovementState = Defaults->MovementState;
+	PrevMovementState = Defaults->PrevMovementState;
+	MovementAction = Defaults->MovementAction;
+	RotationMode = Defaults->RotationMode;
+	Gait = Defaults->Gait;
+	ViewMode = Defaults->ViewMode;
+	OverlayState = Defaults->OverlayState;
+
+	// Essential Information
+	Acceleration = FVector::ZeroVector;
+	bIsMoving = false;
+	bHasMovementInput = false;
+	Speed = 0.f;
+	MovementInputAmount = 0.f;
+	AimYawRate = 0.f;
+	PreviousVelocity = FVector::ZeroVector;
+	PreviousAimYaw = GetControlRotation().Yaw;
+
+	// Rotation caches
 	TargetRotation = GetActorRotation();
+	InAirRotation = GetActorRotation();
 	LastVelocityRotation = GetActorRotation();
 	LastMovementInputRotation = GetActorRotation();
+	YawOffset = 0.f;
+	ResetFixedStep();
+
+	UCharacterMovementComponent* MovementComp = GetCharacterMovement();
+
+	// Landing and timed actions
+	ResetLandingPrediction();
+	if (LSMovementComponent)
+	{
+		LSMovementComponent->StopLandingFriction();
+		LSMovementComponent->StopMantle();
+		LSMovementComponent->StopTimedAction();
+	}
+
+	MovementComp->StopMovementImmediately();
+	MovementComp->SetDefaultMovementMode();
+	OnCharacterMovementModeChanged(MovementComp->MovementMode);
+
+	// Crouch and UnCrouch only request a stance, the capsule is resized by the movement component if it actually differs.
+	Stance = bIsCrouched ? ELSStanceType::Crouching : ELSStanceType::Standing;
+	ApplyDesiredStates();
+
+	if (ULSAnimInstance* AnimInstance = Cast<ULSAnimInstance>(MainAnimInstance))
+	{
+		AnimInstance->ResetLocomotionValues();
+	}
 }
 
 void ALSCharacterBase::OnCharacterMovementModeChanged(const EMovementMode& NewMovementMode)
@@ -273,6 +606,10 @@ void ALSCharacterBase::OnCharacterMovementModeChanged(const EMovementMode& NewMo
 	{
 		OnMovementStateChanged(ELSMovementState::InAir);
 	}
+	else if (LSMovementComponent && LSMovementComponent->IsClimbing())
+	{
+		OnMovementStateChanged(ELSMovementState::Climbing);
+	}
 }
 
 void ALSCharacterBase::OnMovementStateChanged(const ELSMovementState& NewMovementState)
@@ -282,12 +619,17 @@ void ALSCharacterBase::OnMovementStateChanged(const ELSMovementState& NewMovemen
 		return;
 	}
 
+	PrevMovementState = MovementState;
 	MovementState = NewMovementState;
+	PushLocomotionEvent(ELSLocomotionEventType::MovementStateChanged, static_cast<uint8>(PrevMovementState), static_cast<uint8>(MovementState));
+	UpdatePreloadedActionMontages();
 
 	// If the character enters the air, set the In Air Rotation and uncrouch if crouched.
 	// If the character is currently rolling, enable the ragdoll.
 	if (MovementState == ELSMovementState::InAir)
 	{
+		ResetLandingPrediction();
+
 		if (MovementAction == ELSMovementAction::None)
 		{
 			InAirRotation = GetActorRotation();
@@ -301,12 +643,23 @@ void ALSCharacterBase::OnMovementStateChanged(const ELSMovementState& NewMovemen
 			// TODO RagdollStart()
 		}
 	}
-	else if (MovementState == ELSMovementState::InAir && PrevMovementState == ELSMovementState::Mantling)
+
+	// Grab onto the surface standing up.
+	if (MovementState == ELSMovementState::Climbing && Stance == ELSStanceType::Crouching)
+	{
+		UnCrouch();
+	}
+
+	if (MovementState == ELSMovementState::Climbing || PrevMovementState == ELSMovementState::Climbing)
 	{
-		// TODO StopMantling()
+		SetClimbingIKRegistered(MovementState == ELSMovementState::Climbing);
 	}
 
-	// Stop the Mantle Timeline if transitioning to the ragdoll state while mantling.
+	// Stop the mantle if falling or transitioning to the ragdoll state while mantling.
+	if (PrevMovementState == ELSMovementState::Mantling && (MovementState == ELSMovementState::InAir || MovementState == ELSMovementState::Ragdoll))
+	{
+		StopMantle();
+	}
 }
 
 void ALSCharacterBase::OnMovementActionChanged(const ELSMovementAction& NewMovementAction)
@@ -317,6 +670,15 @@ void ALSCharacterBase::OnMovementActionChanged(const ELSMovementAction& NewMovem
 	}
 	ELSMovementAction PrevMovementAction = MovementAction;
 	MovementAction = NewMovementAction;
+	if (PrevMovementAction != ELSMovementAction::None)
+	{
+		PushLocomotionEvent(ELSLocomotionEventType::ActionEnded, static_cast<uint8>(PrevMovementAction), static_cast<uint8>(MovementAction));
+	}
+	if (MovementAction != ELSMovementAction::None)
+	{
+		PushLocomotionEvent(ELSLocomotionEventType::ActionStarted, static_cast<uint8>(PrevMovementAction), static_cast<uint8>(MovementAction));
+	}
+
 	// Make the character crouch if performing a roll.
 	if (MovementAction == ELSMovementAction::Rolling)
 	{
@@ -337,10 +699,19 @@ void ALSCharacterBase::OnMovementActionChanged(const ELSMovementAction& NewMovem
 	}
 }
 
+void ALSCharacterBase::OnTimedActionEnded(ELSMovementAction EndedAction)
+{
+	if (MovementAction == EndedAction)
+	{
+		OnMovementActionChanged(ELSMovementAction::None);
+	}
+}
+
 void ALSCharacterBase::OnStanceChanged(const ELSStanceType& NewStanceType)
 {
 	if (NewStanceType != Stance)
 	{
+		PushLocomotionEvent(ELSLocomotionEventType::StanceChanged, static_cast<uint8>(Stance), static_cast<uint8>(NewStanceType));
 		Stance = NewStanceType;
 	}
 }
@@ -349,6 +720,7 @@ void ALSCharacterBase::OnGaitChanged(const ELSGaitType& NewActualGait)
 {
 	if (Gait != NewActualGait)
 	{
+		PushLocomotionEvent(ELSLocomotionEventType::GaitChanged, static_cast<uint8>(Gait), static_cast<uint8>(NewActualGait));
 		Gait = NewActualGait;
 	}
 }
@@ -374,6 +746,8 @@ void ALSCharacterBase::OnOverlayStateChanged(const ELSOverlayState& NewOverlaySt
 	if (OverlayState != NewOverlayState)
 	{
 		OverlayState = NewOverlayState;
+		UpdateOverlayLayer();
+		UpdatePreloadedActionMontages();
 	}
 }
 
@@ -403,12 +777,42 @@ void ALSCharacterBase::OnViewModeChanged(const ELSViewMode& NewViewMode)
 #pragma region Movement System
 void ALSCharacterBase::SetMovementModel()
 {
-	check(MovementModel.DataTable);
-	MovementData = *MovementModel.DataTable->FindRow<FMovementSettings_State>(MovementModel.RowName, TEXT(""));
+	ULSMovementModelRegistry* Registry = GEngine->GetEngineSubsystem<ULSMovementModelRegistry>();
+	if (!MovementModelAsset.IsNull())
+	{
+		Registry->RequestModelAsync(MovementModelAsset, FOnMovementModelReady::CreateUObject(this, &ALSCharacterBase::OnMovementModelReady));
+		return;
+	}
+
+	MovementModelHandle = Registry->FindOrAddModel(MovementModel);
+	if (!MovementModelHandle.IsValid())
+	{
+		UE_LOG(LogLocomotion, Error, TEXT("'%s' has no valid Movement Model, movement settings will not be updated."), *GetNameSafe(this));
+	}
+}
+
+void ALSCharacterBase::OnMovementModelReady(FLSMovementModelHandle Handle)
+{
+	MovementModelHandle = Handle;
+	if (!MovementModelHandle.IsValid())
+	{
+		UE_LOG(LogLocomotion, Error, TEXT("'%s' failed to load Movement Model Asset '%s'."), *GetNameSafe(this), *MovementModelAsset.ToString());
+	}
+}
+
+const FLSMovementModel* ALSCharacterBase::GetMovementModel() const
+{
+	return MovementModelHandle.IsValid() ? MovementModelHandle->Get() : nullptr;
 }
 
 void ALSCharacterBase::UpdateCharacterMovement()
 {
+	// The movement model may still be streaming in.
+	if (GetMovementModel() == nullptr)
+	{
+		return;
+	}
+
 	// Set the Allowed Gait
 	ELSGaitType AllowedGait = GetAllowedGait();
 
@@ -429,158 +833,67 @@ void ALSCharacterBase::UpdateDynamicMovementSettings(const ELSGaitType& AllowGai
 	SetTargetMovementSettings();
 
 	// Update the Character Max Walk Speed to the configured speeds based on the currently Allowed Gait.
-	switch (AllowGait)
+	const float MaxSpeed = FLSLocomotionRules::GetMaxSpeed(CurMovementSettings, AllowGait);
+	GetCharacterMovement()->MaxWalkSpeed = MaxSpeed;
+	GetCharacterMovement()->MaxWalkSpeedCrouched = MaxSpeed;
+
+	// The Acceleration, Deceleration, and Ground Friction follow the Movement Curve, for fine control over movement behavior at each speed.
+	// The movement component samples it in every move, so a replayed client move does not use the values of the latest actor tick.
+	if (LSMovementComponent)
 	{
-		case ELSGaitType::Walking:
-			GetCharacterMovement()->MaxWalkSpeed = CurMovementSettings.WalkSpeed;
-			GetCharacterMovement()->MaxWalkSpeedCrouched = CurMovementSettings.WalkSpeed;
-			break;
-		case ELSGaitType::Running:
-			GetCharacterMovement()->MaxWalkSpeed = CurMovementSettings.RunSpeed;
-			GetCharacterMovement()->MaxWalkSpeedCrouched = CurMovementSettings.RunSpeed;
-			break;
-		case ELSGaitType::Sprinting:
-			GetCharacterMovement()->MaxWalkSpeed = CurMovementSettings.SprintSpeed;
-			GetCharacterMovement()->MaxWalkSpeedCrouched = CurMovementSettings.SprintSpeed;
-			break;
+		LSMovementComponent->SetMovementCurves(MovementModelHandle, RotationMode);
+	}
+	else
+	{
+		const FVector CurveValue = GetMovementModel()->GetBakedCurves(RotationMode, Stance).SampleMovement(GetMappedSpeed());
+		GetCharacterMovement()->MaxAcceleration = CurveValue.X;
+		GetCharacterMovement()->BrakingDecelerationWalking = CurveValue.Y;
+		GetCharacterMovement()->GroundFriction = CurveValue.Z;
 	}
-
-	// Update the Acceleration, Deceleration, and Ground Friction using the Movement Curve.
-	// This allows for fine control over movement behavior at each speed (May not be suitable for replication).
-	const FVector CurveValue = CurMovementSettings.MovementCurve->GetVectorValue(GetMappedSpeed());
-	GetCharacterMovement()->MaxAcceleration = CurveValue.X;
-	GetCharacterMovement()->BrakingDecelerationWalking = CurveValue.Y;
-	GetCharacterMovement()->GroundFriction = CurveValue.Z;
 }
 
 void ALSCharacterBase::SetTargetMovementSettings()
 {
-	if (RotationMode == ELSRotationMode::VelocityDirection)
-	{
-		if (Stance == ELSStanceType::Standing)
-		{
-			CurMovementSettings = MovementData.VelocityDirection.Standing;
-		}
-		else if (Stance == ELSStanceType::Crouching)
-		{
-			CurMovementSettings = MovementData.VelocityDirection.Crouching;
-		}
-	}
-	else if (RotationMode == ELSRotationMode::LookingDirection)
-	{
-		if (Stance == ELSStanceType::Standing)
-		{
-			CurMovementSettings = MovementData.LookingDirection.Standing;
-		}
-		else if (Stance == ELSStanceType::Crouching)
-		{
-			CurMovementSettings = MovementData.LookingDirection.Crouching;
-		}
-	}
-	else if (RotationMode == ELSRotationMode::Aiming)
+	if (const FLSMovementModel* Model = GetMovementModel())
 	{
-		if (Stance == ELSStanceType::Standing)
-		{
-			CurMovementSettings = MovementData.Aiming.Standing;
-		}
-		else if (Stance == ELSStanceType::Crouching)
-		{
-			CurMovementSettings = MovementData.Aiming.Crouching;
-		}
+		CurMovementSettings = Model->GetSettings(RotationMode, Stance);
 	}
 }
 
 ELSGaitType ALSCharacterBase::GetAllowedGait()
 {
-	ELSGaitType Res = ELSGaitType::Walking;
-	if (Stance == ELSStanceType::Standing)
-	{
-		if (DesiredGait == ELSGaitType::Running)
-		{
-			Res = ELSGaitType::Running;
-		}
-		else if (DesiredGait == ELSGaitType::Sprinting && CanSprint())
-		{
-			Res = ELSGaitType::Sprinting;
-		}
-	}
-	else if (Stance == ELSStanceType::Crouching && (DesiredGait == ELSGaitType::Running || DesiredGait == ELSGaitType::Sprinting))
-	{
-		Res = ELSGaitType::Running;
-	}
-
-	return Res;
+	return FLSLocomotionRules::GetAllowedGait(Stance, DesiredGait, CanSprint());
 }
 
 ELSGaitType ALSCharacterBase::GetActualGait(const ELSGaitType& AllowGait)
 {
-	ELSGaitType Res = ELSGaitType::Walking;
-	const float SpeedOffset = 10.f;
-	if (Speed >= CurMovementSettings.RunSpeed + SpeedOffset)
-	{
-		if (AllowGait == ELSGaitType::Sprinting)
-		{
-			Res = ELSGaitType::Sprinting;
-		}
-		else
-		{
-			Res = ELSGaitType::Running;
-		}
-	}
-	else if (Speed >= CurMovementSettings.WalkSpeed + SpeedOffset)
-	{
-		Res = ELSGaitType::Running;
-	}
-
-	return Res;
+	return FLSLocomotionRules::GetActualGait(Speed, CurMovementSettings, AllowGait);
 }
 
 bool ALSCharacterBase::CanSprint() const
 {
-	bool bRes = false;
-	if (!bHasMovementInput || RotationMode == ELSRotationMode::Aiming)
+	if (!bHasMovementInput)
 	{
-		return bRes;
+		return false;
 	}
 
-	bool bIsOverInputAmount = MovementInputAmount > 0.9f;
-	if (RotationMode == ELSRotationMode::VelocityDirection)
-	{
-		bRes = bIsOverInputAmount;
-	}
-	else if (RotationMode == ELSRotationMode::LookingDirection)
+	float InputToViewYaw = 0.f;
+	if (RotationMode == ELSRotationMode::LookingDirection)
 	{
-		FRotator AccelertionRotator = GetCharacterMovement()->GetCurrentAcceleration().ToOrientationRotator();
-		FRotator DeltaRotator = UKismetMathLibrary::NormalizedDeltaRotator(AccelertionRotator, GetControlRotation());
-		bRes = bIsOverInputAmount && FMath::Abs(DeltaRotator.Yaw) < 50.f;
+		const FRotator AccelerationRotator = GetCharacterMovement()->GetCurrentAcceleration().ToOrientationRotator();
+		InputToViewYaw = UKismetMathLibrary::NormalizedDeltaRotator(AccelerationRotator, GetControlRotation()).Yaw;
 	}
-
-	return bRes;
+	return FLSLocomotionRules::CanSprint(RotationMode, MovementInputAmount, InputToViewYaw);
 }
 
 float ALSCharacterBase::GetMappedSpeed() const
 {
-	// Map the character's current speed to the configured movement speeds with a range of 0-3,
-	// with 0 = stopped, 1 = the Walk Speed, 2 = the Run Speed, and 3 = the Sprint Speed.
-	// This allows you to vary the movement speeds but still use the mapped range in calculations for consistent results.
-
-	const float LocWalkSpeed = CurMovementSettings.WalkSpeed;
-	const float LocRunSpeed = CurMovementSettings.RunSpeed;
-	const float LocSprintSpeed = CurMovementSettings.SprintSpeed;
-
-	const float WalkSpeed = UKismetMathLibrary::MapRangeClamped(Speed, 0.f, LocWalkSpeed, 0.f, 1.f);
-	const float RunSpeed = UKismetMathLibrary::MapRangeClamped(Speed, LocWalkSpeed, LocRunSpeed, 1.f, 2.f);
-	const float SprintSpeed = UKismetMathLibrary::MapRangeClamped(Speed, LocRunSpeed, LocSprintSpeed, 2.f, 3.);
-
-	float MapSpeed = Speed > LocWalkSpeed ? RunSpeed : WalkSpeed;
-	MapSpeed = Speed > LocRunSpeed ? SprintSpeed : MapSpeed;
-
-	return MapSpeed;
+	return FLSLocomotionRules::GetMappedSpeed(Speed, CurMovementSettings);
 }
 
 UAnimMontage* ALSCharacterBase::GetRollAnimation()
 {
-	return nullptr;
+	return GetActionMontage(ELSMovementAction::Rolling);
 }
 
 #pragma endregion
@@ -625,14 +938,12 @@ void ALSCharacterBase::UpdateGroundedRotation()
 			LimitRotation(-100, 100, 20);
 		}
 
-		// Apply the RotationAmount curve from Turn In Place Animations.
-		// The Rotation Amount curve defines how much rotation should be applied each frame,
-		// and is calculated for animations that are animated at 30fps.
-		const float RotationAmount = GetAnimCurveValue("RotationAmount");
-		if (FMath::Abs(RotationAmount) > 0.001f)
+		// Apply the rotation of the active Turn In Place animation, sampled from its precomputed turn table at the montage time.
+		ULSAnimInstance* AnimInstance = Cast<ULSAnimInstance>(MainAnimInstance);
+		float TurnYaw = 0.f;
+		if (AnimInstance && AnimInstance->ConsumeTurnInPlaceYaw(TurnYaw))
 		{
-			const float DeltaSec = UGameplayStatics::GetWorldDeltaSeconds(this) / 1 / 30.f;
-			AddActorWorldRotation(FRotator(0.f, RotationAmount * DeltaSec, 0.f));
+			AddActorWorldRotation(FRotator(0.f, TurnYaw, 0.f));
 			TargetRotation = GetActorRotation();
 		}
 	}
@@ -655,11 +966,7 @@ void ALSCharacterBase::UpdateInAirRotation()
 
 void ALSCharacterBase::SmoothCharacterRotation(const FRotator& Target, float TargetInterpSpeed, float ActorInterpSpeed)
 {
-	const float DeltaTime = UGameplayStatics::GetWorldDeltaSeconds(this);
-	TargetRotation = FMath::RInterpConstantTo(TargetRotation, Target, DeltaTime, TargetInterpSpeed);
-
-	FRotator ActorRotation = FMath::RInterpTo(GetActorRotation(), TargetRotation, DeltaTime, ActorInterpSpeed);
-	SetActorRotation(ActorRotation);
+	SetActorRotation(FLSLocomotionRules::SmoothRotation(GetActorRotation(), TargetRotation, Target, LocomotionDeltaTime, TargetInterpSpeed, ActorInterpSpeed));
 }
 
 void ALSCharacterBase::AddCharacterRotation(const FRotator& DeltaRotation)
@@ -689,9 +996,12 @@ bool ALSCharacterBase::SetActorLocationAndRotationLoc(FVector NewLocation, FRota
 
 float ALSCharacterBase::CalculateGroundedRotationRate() const
 {
-	const float CurveValue = CurMovementSettings.RotationRateCurve->GetFloatValue(GetMappedSpeed());
-	const float AimYawValue = UKismetMathLibrary::MapRangeClamped(AimYawRate, 0.f, 300.f, 1.f, 3.f);
-	return CurveValue * AimYawValue;
+	const FLSMovementModel* Model = GetMovementModel();
+	if (Model == nullptr)
+	{
+		return UKismetMathLibrary::MapRangeClamped(AimYawRate, 0.f, 300.f, 1.f, 3.f);
+	}
+	return FLSLocomotionRules::CalculateGroundedRotationRate(Model->GetBakedCurves(RotationMode, Stance), GetMappedSpeed(), AimYawRate);
 }
 
 bool ALSCharacterBase::CanUpdateMovingRotation() const
@@ -701,6 +1011,855 @@ bool ALSCharacterBase::CanUpdateMovingRotation() const
 
 #pragma endregion
 
+#pragma region Landing Prediction
+
+void ALSCharacterBase::UpdateLandingPrediction()
+{
+	const UCharacterMovementComponent* MovementComp = GetCharacterMovement();
+	const FVector Location = GetActorLocation();
+	const FVector Velocity = GetVelocity();
+	const float GravityZ = MovementComp->GetGravityZ();
+
+	// Re-solve the arc against the confirmed landing height, this is all that runs on most frames.
+	if (LandingPrediction.bValid && !SolveTimeToHeight(Location.Z, Velocity.Z, GravityZ, LandingPrediction.Location.Z, LandingPrediction.TimeToLand))
+	{
+		LandingPrediction.bValid = false;
+	}
+
+	// Only one sweep is pending at a time, its result arrives once the trace scheduler got to it.
+	const ULSTraceSchedulerSubsystem* TraceScheduler = GetWorld()->GetSubsystem<ULSTraceSchedulerSubsystem>();
+	const bool bSweepPending = TraceScheduler && TraceScheduler->IsPending(LandingSweepTicket);
+	const bool bDrifted = FVector2D(Velocity - LandingSweepVelocity).SizeSquared() > FMath::Square(LandingSweepVelocityTolerance);
+	if (!bSweepPending && (bDrifted || GetWorld()->GetTimeSeconds() - LandingSweepTime >= LandingSweepInterval))
+	{
+		RequestLandingSweep(Location, Velocity, GravityZ);
+	}
+
+	// Decide the landing before touchdown, so the landing frame only applies it.
+	if (!LandingPrediction.bValid || !LandingPrediction.bWalkable || LandingPrediction.TimeToLand > LandingLeadTime)
+	{
+		bLandingScheduled = false;
+		return;
+	}
+
+	bLandingScheduled = true;
+	bLandingBreakfall = bBreakFall;
+	LandingBrakingFriction = bHasMovementInput ? 0.5f : 3.f;
+
+	// The roll is preloaded for In Air, make sure it still is in case the overlay or the montage set changed mid air.
+	if (bLandingBreakfall && !PreloadedActionMontages.Contains(ELSMovementAction::Rolling))
+	{
+		UpdatePreloadedActionMontages();
+	}
+}
+
+void ALSCharacterBase::RequestLandingSweep(const FVector& Location, const FVector& Velocity, float GravityZ)
+{
+	// Sweep the chord of the arc up to just past the predicted landing, or the whole prediction window if there is none yet.
+	float SweepTime = LandingPredictionMaxTime;
+	if (LandingPrediction.bValid)
+	{
+		SweepTime = FMath::Min(LandingPrediction.TimeToLand + LandingSweepInterval, LandingPredictionMaxTime);
+	}
+	const FVector End = Location + Velocity * SweepTime + FVector(0.f, 0.f, 0.5f * GravityZ * FMath::Square(SweepTime));
+
+	ULSTraceSchedulerSubsystem* TraceScheduler = GetWorld()->GetSubsystem<ULSTraceSchedulerSubsystem>();
+	if (TraceScheduler == nullptr)
+	{
+		return;
+	}
+
+	const UCapsuleComponent* Capsule = GetCapsuleComponent();
+	FLSTraceRequest Request;
+	Request.Start = Location;
+	Request.End = End;
+	Request.Shape = Capsule->GetCollisionShape();
+	Request.Rotation = Capsule->GetComponentQuat();
+	Request.Channel = Capsule->GetCollisionObjectType();
+	Request.Params = FCollisionQueryParams(SCENE_QUERY_STAT(LandingPrediction), false, this);
+	Capsule->InitSweepCollisionParams(Request.Params, Request.ResponseParams);
+	Request.Priority = TraceScheduler->GetPriority(this);
+	Request.Deadline = GetWorld()->GetTimeSeconds() + LandingSweepInterval;
+	Request.OnCompleted.BindUObject(this, &ALSCharacterBase::OnLandingSweepCompleted);
+
+	LandingSweepTicket = TraceScheduler->RequestTrace(MoveTemp(Request));
+	LandingSweepVelocity = Velocity;
+	LandingSweepTime = GetWorld()->GetTimeSeconds();
+}
+
+void ALSCharacterBase::OnLandingSweepCompleted(FLSTraceTicket Ticket, const FLSTraceResult& Result)
+{
+	if (Ticket != LandingSweepTicket)
+	{
+		return;
+	}
+	LandingSweepTicket.Reset();
+
+	// An expired sweep keeps the last prediction, the next frame asks again.
+	if (MovementState != ELSMovementState::InAir || Result.Status == ELSTraceStatus::Expired)
+	{
+		return;
+	}
+
+	if (Result.Status != ELSTraceStatus::Hit)
+	{
+		LandingPrediction.bValid = false;
+		return;
+	}
+
+	const FHitResult& Hit = Result.Hit;
+	LandingPrediction.Location = Hit.Location;
+	LandingPrediction.ImpactNormal = Hit.ImpactNormal;
+	LandingPrediction.bWalkable = GetCharacterMovement()->IsWalkable(Hit);
+	LandingPrediction.bValid = SolveTimeToHeight(GetActorLocation().Z, GetVelocity().Z, GetCharacterMovement()->GetGravityZ(), Hit.Location.Z, LandingPrediction.TimeToLand);
+}
+
+void ALSCharacterBase::ResetLandingPrediction()
+{
+	if (ULSTraceSchedulerSubsystem* TraceScheduler = GetWorld() ? GetWorld()->GetSubsystem<ULSTraceSchedulerSubsystem>() : nullptr)
+	{
+		TraceScheduler->CancelTrace(LandingSweepTicket);
+	}
+
+	LandingPrediction = FLSLandingPrediction();
+	LandingSweepTicket.Reset();
+	LandingSweepVelocity = FVector::ZeroVector;
+	LandingSweepTime = 0.0;
+	bLandingScheduled = false;
+	bLandingBreakfall = false;
+}
+
+bool ALSCharacterBase::SolveTimeToHeight(double StartZ, double VelocityZ, double GravityZ, double TargetZ, float& OutTime)
+{
+	const double Drop = StartZ - TargetZ;
+	if (FMath::IsNearlyZero(GravityZ))
+	{
+		if (VelocityZ >= 0.0)
+		{
+			return false;
+		}
+		OutTime = static_cast<float>(Drop / -VelocityZ);
+		return OutTime >= 0.f;
+	}
+
+	// 0.5 * g * t^2 + Vz * t + Drop = 0, the later root is on the descending side of the arc.
+	const double Discriminant = VelocityZ * VelocityZ - 2.0 * GravityZ * Drop;
+	if (Discriminant < 0.0)
+	{
+		return false;
+	}
+
+	OutTime = static_cast<float>((-VelocityZ - FMath::Sqrt(Discriminant)) / GravityZ);
+	return OutTime >= 0.f;
+}
+
+#pragma endregion
+
+#pragma region Mantle System
+
+bool ALSCharacterBase::TryMantle()
+{
+	if (MovementState != ELSMovementState::Grounded && MovementState != ELSMovementState::InAir)
+	{
+		return false;
+	}
+	return RequestMantle();
+}
+
+bool ALSCharacterBase::RequestMantle()
+{
+	// Only whoever produces the moves asks, the server gets the request with the client's move.
+	if (MovementAction != ELSMovementAction::None || LSMovementComponent == nullptr || !IsLocallyControlled())
+	{
+		return false;
+	}
+
+	LSMovementComponent->RequestMantle();
+	return true;
+}
+
+void ALSCharacterBase::OnMantleRequested()
+{
+	// Picked from the movement mode of the move rather than the Movement State of the last actor tick, so both sides trace the same ledge.
+	MantleCheck(GetCharacterMovement()->IsFalling() ? FallingMantleTraceSettings : GroundedMantleTraceSettings);
+}
+
+bool ALSCharacterBase::MantleCheck(const FLSMantleTraceSettings& TraceSettings)
+{
+	if (MovementAction != ELSMovementAction::None)
+	{
+		return false;
+	}
+
+	UWorld* World = GetWorld();
+	const UCharacterMovementComponent* MovementComp = GetCharacterMovement();
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(MantleCheck), false, this);
+
+	// Step 1: Trace forward to find a wall / object the character cannot walk on.
+	const FVector TraceDirection = GetActorForwardVector();
+	const FVector CapsuleBaseLocation = GetCapsuleBaseLocation(2.f);
+	FVector TraceStart = CapsuleBaseLocation + TraceDirection * -30.f;
+	TraceStart.Z += (TraceSettings.MaxLedgeHeight + TraceSettings.MinLedgeHeight) / 2.f;
+	const FVector TraceEnd = TraceStart + TraceDirection * TraceSettings.ReachDistance;
+	const float HalfHeight = 1.f + (TraceSettings.MaxLedgeHeight - TraceSettings.MinLedgeHeight) / 2.f;
+
+	FHitResult HitResult;
+	World->SweepSingleByChannel(HitResult, TraceStart, TraceEnd, FQuat::Identity, MantleTraceChannel, FCollisionShape::MakeCapsule(TraceSettings.ForwardTraceRadius, HalfHeight), Params);
+	if (!HitResult.IsValidBlockingHit() || MovementComp->IsWalkable(HitResult))
+	{
+		return false;
+	}
+
+	const UPrimitiveComponent* WallComponent = HitResult.GetComponent();
+	if (WallComponent && WallComponent->GetComponentVelocity().Size() > AcceptableLedgeVelocity)
+	{
+		return false;
+	}
+
+	const FVector InitialTraceImpactPoint = HitResult.ImpactPoint;
+	const FVector InitialTraceNormal = HitResult.ImpactNormal;
+
+	// Step 2: Trace downward from the first trace's Impact Point and determine if the hit location is walkable.
+	FVector DownwardTraceEnd = InitialTraceImpactPoint;
+	DownwardTraceEnd.Z = CapsuleBaseLocation.Z;
+	DownwardTraceEnd += InitialTraceNormal * -15.f;
+	FVector DownwardTraceStart = DownwardTraceEnd;
+	DownwardTraceStart.Z += TraceSettings.MaxLedgeHeight + TraceSettings.DownwardTraceRadius + 1.f;
+
+	World->SweepSingleByChannel(HitResult, DownwardTraceStart, DownwardTraceEnd, FQuat::Identity, MantleTraceChannel, FCollisionShape::MakeSphere(TraceSettings.DownwardTraceRadius), Params);
+	if (!MovementComp->IsWalkable(HitResult))
+	{
+		return false;
+	}
+
+	const FVector DownTraceLocation(HitResult.Location.X, HitResult.Location.Y, HitResult.ImpactPoint.Z);
+	UPrimitiveComponent* LedgeComponent = HitResult.GetComponent();
+
+	// Step 3: Check if the capsule has room to stand at the downward trace's location.
+	const FVector CapsuleLocationFromBase = GetCapsuleLocationFromBase(DownTraceLocation, 2.f);
+	if (!CapsuleHasRoomCheck(CapsuleLocationFromBase, 0.f, 0.f))
+	{
+		return false;
+	}
+
+	// Step 4: Determine the Mantle Type by checking the movement mode and Mantle Height.
+	const FTransform TargetTransform((InitialTraceNormal * FVector(-1.f, -1.f, 0.f)).ToOrientationRotator(), CapsuleLocationFromBase);
+	const float MantleHeight = (CapsuleLocationFromBase - GetActorLocation()).Z;
+	const ELSMovementAction MantleAction = MovementComp->IsMovingOnGround() && MantleHeight > HighMantleMinHeight ? ELSMovementAction::HighMantle : ELSMovementAction::LowMantle;
+
+	// Step 5: If everything checks out, start the Mantle.
+	return MantleStart(MantleHeight, LedgeComponent, TargetTransform, MantleAction);
+}
+
+bool ALSCharacterBase::MantleStart(float MantleHeight, UPrimitiveComponent* LedgeComponent, const FTransform& LedgeTransform, ELSMovementAction MantleAction)
+{
+	if (LSMovementComponent == nullptr)
+	{
+		return false;
+	}
+
+	// The movement only needs the correction curve, a montage that is not resident (e.g. on a dedicated server) only loses the animation.
+	UAnimMontage* Montage = GetActionMontage(MantleAction);
+	if (Montage == nullptr)
+	{
+		UE_LOG(LogLocomotion, Verbose, TEXT("'%s' mantles without the %s montage, it is not loaded."), *GetName(), *UEnum::GetValueAsString(MantleAction));
+	}
+
+	// Step 1: Get the Mantle Asset and use it to set the new Mantle Params.
+	const FLSMantleAsset& MantleAsset = MantleAction == ELSMovementAction::HighMantle ? HighMantleAsset : LowMantleAsset;
+	const FVector2f HeightRange(MantleAsset.LowHeight, MantleAsset.HighHeight);
+
+	FLSMantleParams MantleParams;
+	MantleParams.PositionCorrectionCurve = MantleAsset.PositionCorrectionCurve;
+	MantleParams.PlayRate = FMath::GetMappedRangeValueClamped(HeightRange, FVector2f(MantleAsset.LowPlayRate, MantleAsset.HighPlayRate), MantleHeight);
+	MantleParams.StartingPosition = FMath::GetMappedRangeValueClamped(HeightRange, FVector2f(MantleAsset.LowStartPosition, MantleAsset.HighStartPosition), MantleHeight);
+
+	// Step 2: Keep the target relative to the ledge component so the mantle follows moving objects.
+	MantleParams.LedgeComponent = LedgeComponent;
+	MantleParams.LedgeTransform = LedgeComponent ? LedgeTransform.GetRelativeTransform(LedgeComponent->GetComponentTransform()) : LedgeTransform;
+
+	// Step 3: Calculate the Starting Offset (offset amount between the actor and target transform).
+	MantleParams.ActualStartOffset = GetActorLocation() - LedgeTransform.GetLocation();
+	MantleParams.ActualStartRotationOffset = (GetActorRotation() - LedgeTransform.Rotator()).GetNormalized();
+
+	// Step 4: Calculate the Animated Start Offset from the Target Location. This would be the location the actual animation starts at relative to the Target Transform.
+	FVector RotatedVector = LedgeTransform.GetRotation().Vector() * MantleAsset.StartingOffset.Y;
+	RotatedVector.Z = MantleAsset.StartingOffset.Z;
+	MantleParams.AnimatedStartOffset = -RotatedVector;
+
+	// Step 5: The mantle lasts for the rest of the correction curve after the starting position.
+	float MinTime = 0.f;
+	float MaxTime = Montage ? Montage->GetPlayLength() : 0.f;
+	if (MantleParams.PositionCorrectionCurve)
+	{
+		MantleParams.PositionCorrectionCurve->GetTimeRange(MinTime, MaxTime);
+	}
+	const float Duration = (MaxTime - MantleParams.StartingPosition) / FMath::Max(MantleParams.PlayRate, UE_KINDA_SMALL_NUMBER);
+	if (Duration <= 0.f)
+	{
+		UE_LOG(LogLocomotion, Warning, TEXT("'%s' cannot mantle, %s has neither a position correction curve nor a loaded montage."), *GetName(), *UEnum::GetValueAsString(MantleAction));
+		return false;
+	}
+
+	// Step 6: Start the mantle movement and set the Movement State to Mantling.
+	LSMovementComponent->StartMantle(MantleParams, MantleAction, Duration);
+	OnMovementStateChanged(ELSMovementState::Mantling);
+	OnMovementActionChanged(MantleAction);
+
+	// Step 7: Play the Anim Montage.
+	if (Montage && IsValid(MainAnimInstance))
+	{
+		MainAnimInstance->Montage_Play(Montage, MantleParams.PlayRate, EMontagePlayReturnType::MontageLength, MantleParams.StartingPosition, false);
+	}
+	return true;
+}
+
+void ALSCharacterBase::StopMantle()
+{
+	if (LSMovementComponent)
+	{
+		LSMovementComponent->StopMantle();
+		LSMovementComponent->StopTimedAction();
+	}
+
+	if (MovementAction == ELSMovementAction::LowMantle || MovementAction == ELSMovementAction::HighMantle)
+	{
+		OnMovementActionChanged(ELSMovementAction::None);
+	}
+}
+
+bool ALSCharacterBase::CapsuleHasRoomCheck(const FVector& TargetLocation, float HeightOffset, float RadiusOffset) const
+{
+	// Perform a trace to see if the capsule has room to be at the target location.
+	const UCapsuleComponent* Capsule = GetCapsuleComponent();
+	const float ZTarget = Capsule->GetScaledCapsuleHalfHeight_WithoutHemisphere() - RadiusOffset + HeightOffset;
+	const FVector TraceStart = TargetLocation + FVector(0.f, 0.f, ZTarget);
+	const FVector TraceEnd = TargetLocation - FVector(0.f, 0.f, ZTarget);
+	const float Radius = Capsule->GetScaledCapsuleRadius() + RadiusOffset;
+
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(MantleRoomCheck), false, this);
+	FCollisionResponseParams ResponseParams;
+	Capsule->InitSweepCollisionParams(Params, ResponseParams);
+	return !GetWorld()->SweepTestByChannel(TraceStart, TraceEnd, FQuat::Identity, Capsule->GetCollisionObjectType(), FCollisionShape::MakeSphere(Radius), Params, ResponseParams);
+}
+
+#pragma endregion
+
+#pragma region Climbing
+
+bool ALSCharacterBase::TryClimb()
+{
+	// Only whoever produces the moves asks, the server gets the request with the client's move.
+	if (MovementAction != ELSMovementAction::None || LSMovementComponent == nullptr || !IsLocallyControlled())
+	{
+		return false;
+	}
+
+	LSMovementComponent->RequestClimb();
+	return true;
+}
+
+void ALSCharacterBase::StopClimbing()
+{
+	if (LSMovementComponent)
+	{
+		LSMovementComponent->StopClimbing();
+	}
+}
+
+void ALSCharacterBase::UpdateClimbing()
+{
+	if (LSMovementComponent && LSMovementComponent->HasReachedClimbLedge())
+	{
+		RequestMantle();
+	}
+}
+
+void ALSCharacterBase::SetClimbingIKRegistered(bool bRegistered)
+{
+	// Not created on dedicated servers.
+	ULSClimbingIKSubsystem* ClimbingIKSubsystem = GetWorld() ? GetWorld()->GetSubsystem<ULSClimbingIKSubsystem>() : nullptr;
+	if (ClimbingIKSubsystem == nullptr)
+	{
+		return;
+	}
+
+	if (bRegistered)
+	{
+		ClimbingIKSubsystem->RegisterClimber(this);
+	}
+	else
+	{
+		ClimbingIKSubsystem->UnregisterClimber(this);
+	}
+}
+
+#pragma endregion
+
+#pragma region Animation Budget
+
+void ALSCharacterBase::UpdateAnimationSignificance(float ClosestViewDistance)
+{
+	USkeletalMeshComponentBudgeted* BudgetedMesh = Cast<USkeletalMeshComponentBudgeted>(GetMesh());
+	if (BudgetedMesh == nullptr)
+	{
+		return;
+	}
+
+	if (IsLocallyControlled() && IsPlayerControlled())
+	{
+		BudgetedMesh->SetComponentSignificance(1.f, true);
+		return;
+	}
+
+	float Significance = 1.f - FMath::Clamp(ClosestViewDistance / AnimationSignificanceMaxDistance, 0.f, 1.f);
+	if (!BudgetedMesh->WasRecentlyRendered(0.2f))
+	{
+		Significance *= NotRenderedSignificanceScale;
+	}
+
+	// Mantles, climbing and landings read badly at a low rate, only idles get scaled down.
+	if (MovementState == ELSMovementState::Grounded && !bIsMoving && MovementAction == ELSMovementAction::None)
+	{
+		Significance *= IdleSignificanceScale;
+	}
+
+	BudgetedMesh->SetComponentSignificance(Significance);
+}
+
+float ALSCharacterBase::GetClosestViewDistance() const
+{
+	float ClosestDistanceSquared = MAX_flt;
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		if (PlayerController && PlayerController->IsLocalController())
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+			ClosestDistanceSquared = FMath::Min(ClosestDistanceSquared, static_cast<float>(FVector::DistSquared(ViewLocation, GetActorLocation())));
+		}
+	}
+
+	return ClosestDistanceSquared == MAX_flt ? MAX_flt : FMath::Sqrt(ClosestDistanceSquared);
+}
+
+void ALSCharacterBase::OnAnimationReduceWork(USkeletalMeshComponentBudgeted* Component, bool bReduce)
+{
+	if (ULSAnimInstance* AnimInstance = Cast<ULSAnimInstance>(MainAnimInstance))
+	{
+		AnimInstance->SetReducedWork(bReduce);
+	}
+}
+
+#pragma endregion
+
+#pragma region Animation Sharing
+
+void ALSCharacterBase::UpdateAnimationSharing(float ClosestViewDistance)
+{
+	if (AnimationSharingSetup == nullptr)
+	{
+		return;
+	}
+
+	// The locally controlled character and actions the shared states cannot show always run the full anim instance.
+	const bool bCanShare = !(IsLocallyControlled() && IsPlayerControlled()) && MovementAction == ELSMovementAction::None && MovementState != ELSMovementState::Ragdoll;
+	if (bUsesSharedAnimation)
+	{
+		if (!bCanShare || ClosestViewDistance < AnimationSharingPromoteDistance)
+		{
+			StopSharedAnimation();
+		}
+	}
+	else if (bCanShare && ClosestViewDistance > AnimationSharingDistance)
+	{
+		StartSharedAnimation();
+	}
+}
+
+void ALSCharacterBase::StartSharedAnimation()
+{
+	if (!UAnimationSharingManager::AnimationSharingEnabled())
+	{
+		return;
+	}
+
+	UAnimationSharingManager* Manager = UAnimationSharingManager::GetAnimationSharingManager(this);
+	if (Manager == nullptr)
+	{
+		UAnimationSharingManager::CreateAnimationSharingManager(this, AnimationSharingSetup);
+		Manager = UAnimationSharingManager::GetAnimationSharingManager(this);
+	}
+
+	const USkeletalMesh* SkeletalMesh = GetMesh()->GetSkeletalMeshAsset();
+	if (Manager && SkeletalMesh && Manager->RegisterActorWithSkeletonBP(this, SkeletalMesh->GetSkeleton()))
+	{
+		bUsesSharedAnimation = true;
+	}
+}
+
+void ALSCharacterBase::StopSharedAnimation()
+{
+	if (!bUsesSharedAnimation)
+	{
+		return;
+	}
+	bUsesSharedAnimation = false;
+
+	if (UAnimationSharingManager* Manager = UAnimationSharingManager::GetAnimationSharingManager(this))
+	{
+		Manager->UnregisterActor(this);
+	}
+	GetMesh()->SetLeaderPoseComponent(nullptr);
+
+	// The anim instance was not updated while following the shared pose, start it from a clean slate.
+	if (ULSAnimInstance* AnimInstance = Cast<ULSAnimInstance>(MainAnimInstance))
+	{
+		AnimInstance->ResetLocomotionValues();
+	}
+}
+
+#pragma endregion
+
+#pragma region Mass LOD
+
+bool ALSCharacterBase::CanConvertToMassEntity() const
+{
+	return bAllowMassLOD && !IsPlayerControlled() && MovementState == ELSMovementState::Grounded && MovementAction == ELSMovementAction::None && GetMovementModel() != nullptr;
+}
+
+void ALSCharacterBase::GetLocomotionFragment(FLSLocomotionFragment& OutFragment) const
+{
+	OutFragment.DesiredGait = DesiredGait;
+	OutFragment.Gait = Gait;
+	OutFragment.Stance = Stance;
+	OutFragment.RotationMode = RotationMode;
+	OutFragment.OverlayState = OverlayState;
+	OutFragment.Velocity = GetVelocity();
+	OutFragment.TargetRotation = TargetRotation;
+
+	// Keep walking the way the AI was heading.
+	const UCharacterMovementComponent* MovementComp = GetCharacterMovement();
+	const float MaxAcceleration = MovementComp->GetMaxAcceleration();
+	OutFragment.MovementInput = MaxAcceleration > 0.f ? MovementComp->GetCurrentAcceleration() / MaxAcceleration : FVector::ZeroVector;
+}
+
+void ALSCharacterBase::ApplyLocomotionFragment(const FLSLocomotionFragment& Fragment)
+{
+	DesiredGait = Fragment.DesiredGait;
+	DesiredStance = Fragment.Stance;
+	DesiredRotationMode = Fragment.RotationMode;
+	OnOverlayStateChanged(Fragment.OverlayState);
+	ApplyDesiredStates();
+	OnGaitChanged(Fragment.Gait);
+
+	TargetRotation = Fragment.TargetRotation;
+	LastVelocityRotation = Fragment.Velocity.IsNearlyZero() ? GetActorRotation() : Fragment.Velocity.ToOrientationRotator();
+	GetCharacterMovement()->Velocity = Fragment.Velocity;
+	PreviousVelocity = Fragment.Velocity;
+}
+
+#pragma endregion
+
+#pragma region Crowd Avoidance
+
+bool ALSCharacterBase::ShouldSteerForAvoidance() const
+{
+	return bUseLSAvoidance && !IsPlayerControlled() && MovementState == ELSMovementState::Grounded && MovementAction == ELSMovementAction::None;
+}
+
+#pragma endregion
+
+#pragma region Input Recording
+
+void ALSCharacterBase::GetRecordedInput(FLSInputFrame& OutFrame) const
+{
+	// The pending input already has the axis shaping of PlayerMovementInput applied, project it back onto the axes.
+	FVector Forward;
+	FVector Right;
+	GetMovementInputAxes(Forward, Right);
+	const FVector PendingInput = GetPendingMovementInputVector();
+	OutFrame.SetMoveAxes(PendingInput | Forward, PendingInput | Right);
+
+	OutFrame.SetControlRotation(GetControlRotation());
+	OutFrame.SetToggles(DesiredGait, DesiredStance, DesiredRotationMode, bSprintHeld);
+}
+
+void ALSCharacterBase::ApplyRecordedInput(const FLSInputFrame& Frame)
+{
+	if (Controller)
+	{
+		Controller->SetControlRotation(Frame.GetControlRotation());
+	}
+
+	DesiredGait = Frame.GetDesiredGait();
+	bSprintHeld = Frame.IsSprintHeld();
+
+	if (DesiredRotationMode != Frame.GetDesiredRotationMode())
+	{
+		DesiredRotationMode = Frame.GetDesiredRotationMode();
+		OnRotationModeChanged(DesiredRotationMode);
+	}
+
+	if (DesiredStance != Frame.GetDesiredStance())
+	{
+		DesiredStance = Frame.GetDesiredStance();
+		if (DesiredStance == ELSStanceType::Standing)
+		{
+			UnCrouch();
+		}
+		else
+		{
+			Crouch();
+		}
+	}
+
+	// Drop any live input, the axes are mapped with the recorded control rotation.
+	ConsumeMovementInputVector();
+	FVector Forward;
+	FVector Right;
+	GetMovementInputAxes(Forward, Right);
+	AddMovementInput(Forward, Frame.GetMoveForward());
+	AddMovementInput(Right, Frame.GetMoveRight());
+}
+
+void ALSCharacterBase::GetRecordedState(FLSStateFrame& OutState) const
+{
+	OutState.Location = FVector3f(GetActorLocation());
+	OutState.Velocity = FVector3f(GetVelocity());
+	OutState.Yaw = GetActorRotation().Yaw;
+	OutState.Gait = static_cast<uint8>(Gait);
+	OutState.Stance = static_cast<uint8>(Stance);
+	OutState.RotationMode = static_cast<uint8>(RotationMode);
+	OutState.MovementState = static_cast<uint8>(MovementState);
+}
+
+void ALSCharacterBase::ApplyRecordedState(const FLSStateFrame& State)
+{
+	SetActorLocationAndRotationLoc(FVector(State.Location), FRotator(0.f, State.Yaw, 0.f), false, nullptr, ETeleportType::ResetPhysics);
+
+	UCharacterMovementComponent* MovementComp = GetCharacterMovement();
+	if (LSMovementComponent)
+	{
+		LSMovementComponent->StopMantle();
+		LSMovementComponent->StopTimedAction();
+	}
+	OnMovementActionChanged(ELSMovementAction::None);
+
+	// The movement state follows the movement mode. Mantles, climbs and ragdolls depend on more than a recording has, they start grounded.
+	const ELSMovementState RecordedMovementState = static_cast<ELSMovementState>(State.MovementState);
+	if (RecordedMovementState == ELSMovementState::InAir)
+	{
+		MovementComp->SetMovementMode(MOVE_Falling);
+	}
+	else
+	{
+		if (RecordedMovementState != ELSMovementState::Grounded)
+		{
+			UE_LOG(LogLocomotion, Warning, TEXT("'%s' replays a recording starting in %s grounded."), *GetName(), *UEnum::GetValueAsString(RecordedMovementState));
+		}
+		MovementComp->SetMovementMode(MOVE_Walking);
+	}
+
+	// The first replayed frame sets the desired states again, the actual ones are restored right away.
+	DesiredStance = static_cast<ELSStanceType>(State.Stance);
+	DesiredRotationMode = static_cast<ELSRotationMode>(State.RotationMode);
+	ApplyDesiredStates();
+	if (DesiredStance == ELSStanceType::Crouching)
+	{
+		MovementComp->Crouch(false);
+	}
+	else
+	{
+		MovementComp->UnCrouch(false);
+	}
+	OnGaitChanged(static_cast<ELSGaitType>(State.Gait));
+
+	MovementComp->Velocity = FVector(State.Velocity);
+	PreviousVelocity = FVector(State.Velocity);
+	LastVelocityRotation = GetActorRotation();
+	LastMovementInputRotation = GetActorRotation();
+	ResetFixedStep();
+}
+
+#pragma endregion
+
+#pragma region Overlay Layers
+
+void ALSCharacterBase::UpdateOverlayLayer()
+{
+	if (!IsValid(OverlayLayerSet))
+	{
+		return;
+	}
+
+	const TSoftClassPtr<UAnimInstance> DesiredLayer = OverlayLayerSet->GetLayerClass(OverlayState);
+	const TSoftClassPtr<UAnimInstance>& CurrentTarget = PendingOverlayLayer.IsNull() ? ActiveOverlayLayer : PendingOverlayLayer;
+	if (DesiredLayer == CurrentTarget)
+	{
+		return;
+	}
+
+	ULSOverlayLayerSubsystem* LayerSubsystem = GetWorld()->GetSubsystem<ULSOverlayLayerSubsystem>();
+
+	// Drop a request that was superseded before it finished loading.
+	if (!PendingOverlayLayer.IsNull())
+	{
+		LayerSubsystem->ReleaseLayer(PendingOverlayLayer);
+		PendingOverlayLayer.Reset();
+	}
+
+	if (DesiredLayer.IsNull() || DesiredLayer == ActiveOverlayLayer)
+	{
+		// No layer for this overlay, fall back to the main graph.
+		if (DesiredLayer.IsNull() && !ActiveOverlayLayer.IsNull())
+		{
+			GetMesh()->UnlinkAnimClassLayers(ActiveOverlayLayer.Get());
+			LayerSubsystem->ReleaseLayer(ActiveOverlayLayer);
+			ActiveOverlayLayer.Reset();
+		}
+		return;
+	}
+
+	PendingOverlayLayer = DesiredLayer;
+	LayerSubsystem->RequestLayer(DesiredLayer, FOnOverlayLayerReady::CreateUObject(this, &ALSCharacterBase::OnOverlayLayerReady, DesiredLayer));
+}
+
+void ALSCharacterBase::OnOverlayLayerReady(TSubclassOf<UAnimInstance> LayerClass, TSoftClassPtr<UAnimInstance> RequestedLayer)
+{
+	// A newer overlay was requested while this one was loading, its reference was already released.
+	if (RequestedLayer != PendingOverlayLayer)
+	{
+		return;
+	}
+
+	ULSOverlayLayerSubsystem* LayerSubsystem = GetWorld()->GetSubsystem<ULSOverlayLayerSubsystem>();
+	PendingOverlayLayer.Reset();
+	if (!LayerClass)
+	{
+		LayerSubsystem->ReleaseLayer(RequestedLayer);
+		return;
+	}
+
+	// Linking replaces the layers of the old class that share an interface with the new one.
+	if (!ActiveOverlayLayer.IsNull())
+	{
+		GetMesh()->UnlinkAnimClassLayers(ActiveOverlayLayer.Get());
+		LayerSubsystem->ReleaseLayer(ActiveOverlayLayer);
+	}
+	GetMesh()->LinkAnimClassLayers(LayerClass);
+	ActiveOverlayLayer = RequestedLayer;
+}
+
+void ALSCharacterBase::ReleaseOverlayLayers()
+{
+	ULSOverlayLayerSubsystem* LayerSubsystem = GetWorld() ? GetWorld()->GetSubsystem<ULSOverlayLayerSubsystem>() : nullptr;
+	if (LayerSubsystem == nullptr)
+	{
+		return;
+	}
+
+	if (!PendingOverlayLayer.IsNull())
+	{
+		LayerSubsystem->ReleaseLayer(PendingOverlayLayer);
+		PendingOverlayLayer.Reset();
+	}
+	if (!ActiveOverlayLayer.IsNull())
+	{
+		LayerSubsystem->ReleaseLayer(ActiveOverlayLayer);
+		ActiveOverlayLayer.Reset();
+	}
+}
+
+#pragma endregion
+
+#pragma region Action Montages
+
+void ALSCharacterBase::UpdatePreloadedActionMontages()
+{
+	if (!IsValid(ActionMontageSet))
+	{
+		return;
+	}
+
+	const TArray<ELSMovementAction, TInlineAllocator<4>> PredictedActions = GetPredictedActions(MovementState);
+
+	// Release montages the current state can no longer trigger.
+	for (auto It = PreloadedActionMontages.CreateIterator(); It; ++It)
+	{
+		if (!PredictedActions.Contains(It->Key))
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	for (const ELSMovementAction Action : PredictedActions)
+	{
+		const TSoftObjectPtr<UAnimMontage> Montage = ActionMontageSet->FindMontage(Action, OverlayState);
+		if (Montage.IsNull())
+		{
+			PreloadedActionMontages.Remove(Action);
+			continue;
+		}
+
+		FPreloadedMontage& Preloaded = PreloadedActionMontages.FindOrAdd(Action);
+		if (Preloaded.Montage == Montage && Preloaded.Handle.IsValid())
+		{
+			continue;
+		}
+
+		// Replacing the handle releases the montage of the previous overlay.
+		Preloaded.Montage = Montage;
+		Preloaded.Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(Montage.ToSoftObjectPath(), FStreamableDelegate(), FStreamableManager::AsyncLoadHighPriority, true);
+	}
+}
+
+UAnimMontage* ALSCharacterBase::GetActionMontage(ELSMovementAction Action) const
+{
+	UAnimMontage* Montage = nullptr;
+	if (IsValid(ActionMontageSet))
+	{
+		Montage = ActionMontageSet->FindMontage(Action, OverlayState).Get();
+		UE_CLOG(Montage == nullptr, LogLocomotion, Verbose, TEXT("'%s' action montage for %s is not resident yet."), *GetNameSafe(this), *UEnum::GetValueAsString(Action));
+	}
+
+	return Montage;
+}
+
+TArray<ELSMovementAction, TInlineAllocator<4>> ALSCharacterBase::GetPredictedActions(ELSMovementState State)
+{
+	TArray<ELSMovementAction, TInlineAllocator<4>> Actions;
+	switch (State)
+	{
+		case ELSMovementState::Grounded:
+			// Rolling on input, mantling from a jump.
+			Actions = {ELSMovementAction::Rolling, ELSMovementAction::LowMantle, ELSMovementAction::HighMantle};
+			break;
+		case ELSMovementState::InAir:
+			// Breakfall roll on landing, mantling while falling.
+			Actions = {ELSMovementAction::Rolling, ELSMovementAction::LowMantle, ELSMovementAction::HighMantle};
+			break;
+		case ELSMovementState::Climbing:
+			// Climbing up ends in a mantle.
+			[[fallthrough]];
+		case ELSMovementState::Mantling:
+			// Keep the playing mantle resident, a mantle can chain into another.
+			Actions = {ELSMovementAction::LowMantle, ELSMovementAction::HighMantle};
+			break;
+		case ELSMovementState::Ragdoll:
+			Actions = {ELSMovementAction::GettingUp};
+			break;
+		default:
+			break;
+	}
+
+	return Actions;
+}
+
+#pragma endregion
+
 #pragma region Utility
 float ALSCharacterBase::GetAnimCurveValue(const FName& CurveName) const
 {
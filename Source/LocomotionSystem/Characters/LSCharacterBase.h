@@ -3,94 +3,57 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Data/ClimbingIKSettings.h"
+#include "Data/LocomotionEvents.h"
+#include "Data/LocomotionSnapshot.h"
+#include "Data/LocomotionTypes.h"
+#include "Data/MantleSettings.h"
+#include "Data/MovementModelRegistry.h"
 #include "Data/MovementSettings.h"
 #include "Engine/DataTable.h"
 #include "GameFramework/Character.h"
+#include "Subsystems/LSTraceSchedulerSubsystem.h"
 
 #include "LSCharacterBase.generated.h"
 
-UENUM(BlueprintType)
-enum class ELSGaitType
-{
-	Walking,
-	Running,
-	Sprinting
-};
-
-UENUM(BlueprintType)
-enum class ELSStanceType
-{
-	Standing,
-	Crouching,
-};
-
-UENUM(BlueprintType)
-enum class ELSRotationMode
-{
-	VelocityDirection,
-	LookingDirection,
-	Aiming
-};
-
-UENUM(BlueprintType)
-enum class ELSViewMode
-{
-	ThirdPerson,
-	FirstPerson,
-};
-
-UENUM(BlueprintType)
-enum class ELSMovementState
-{
-	None,
-	Grounded,
-	InAir,
-	Mantling,
-	Ragdoll
-};
-
-UENUM(BlueprintType)
-enum class ELSMovementAction
-{
-	None,
-	LowMantle,
-	HighMantle,
-	Rolling,
-	GettingUp
-};
+class UAnimMontage;
+class USkeletalMeshComponentBudgeted;
 
-UENUM(BlueprintType)
-enum class ELSOverlayState
+// Where and when an in air character is expected to land.
+struct FLSLandingPrediction
 {
-	Default,
-	Masculine,
-	Feminine,
-	Injured,
-	HandsTied,
-	Rifle,
-	Pistol1H,
-	Pistol2H,
-	Bow,
-	Torch,
-	Binoculars,
-	Box,
-	Barrel,
+	// Capsule location at the moment of landing.
+	FVector Location = FVector::ZeroVector;
+	FVector ImpactNormal = FVector::UpVector;
+	float TimeToLand = 0.f;
+	bool bValid = false;
+	bool bWalkable = false;
 };
 
-class UAnimMontage;
-
 UCLASS(config = Game)
 class ALSCharacterBase : public ACharacter
 {
 	GENERATED_BODY()
 
 public:
+	ALSCharacterBase(const FObjectInitializer& ObjectInitializer);
+
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void Tick(float DeltaSeconds) override;
 #pragma region References
 protected:
 	UPROPERTY()
 	TObjectPtr<class UAnimInstance> MainAnimInstance;
+
+	UPROPERTY()
+	TObjectPtr<class ULSCharacterMovementComponent> LSMovementComponent;
+
+public:
+	ULSCharacterMovementComponent* GetLSMovementComponent() const
+	{
+		return LSMovementComponent;
+	}
 #pragma endregion
 
 #pragma region Input
@@ -98,6 +61,9 @@ protected:
 	void PlayerMovementInput(bool IsForwardAxis);
 	FVector GetPlayerMovementInput();
 
+	// Directions the forward and right movement axes move the character in.
+	void GetMovementInputAxes(FVector& OutForward, FVector& OutRight) const;
+
 protected:
 	UPROPERTY(EditDefaultsOnly, Category = "Locomotion|Input")
 	ELSRotationMode DesiredRotationMode = ELSRotationMode::LookingDirection;
@@ -156,6 +122,81 @@ protected:
 	float PreviousAimYaw = 0.f;
 #pragma endregion
 
+#pragma region Locomotion Snapshot
+public:
+	// Latest published locomotion state. Read it in place on the game thread, other threads copy it out with Read.
+	const FLSLocomotionSnapshotBuffer& GetLocomotionSnapshot() const
+	{
+		return LocomotionSnapshot;
+	}
+
+	ELSMovementState GetMovementState() const
+	{
+		return MovementState;
+	}
+
+protected:
+	// Published once per frame at the end of the actor tick. The mesh ticks after the actor, so animation reads this frame's values.
+	void PublishLocomotionSnapshot();
+
+protected:
+	FLSLocomotionSnapshotBuffer LocomotionSnapshot;
+#pragma endregion
+
+#pragma region Locomotion Events
+public:
+	// Subscribe on the game thread and drain the returned queue from a single thread. Releasing the queue unsubscribes.
+	FLSLocomotionEventQueueRef SubscribeLocomotionEvents()
+	{
+		return LocomotionEvents.Subscribe();
+	}
+
+protected:
+	void PushLocomotionEvent(ELSLocomotionEventType Type, uint8 PreviousValue = 0, uint8 NewValue = 0, float EventSpeed = 0.f);
+
+protected:
+	FLSLocomotionEventStream LocomotionEvents;
+#pragma endregion
+
+#pragma region Fixed Step
+protected:
+	// One locomotion update: the essential values are sampled over SampleDeltaTime, then the rotation is integrated in NumSteps steps of StepDeltaTime.
+	void UpdateLocomotion(float SampleDeltaTime, float StepDeltaTime, int32 NumSteps);
+
+	// Run the locomotion update at FixedStepRate with an accumulator, and show the mesh rotated between the last two steps.
+	void UpdateFixedStepLocomotion(float DeltaSeconds);
+
+	// Rotate the mesh so it shows the rotation while the actor keeps its own.
+	void SetMeshPresentedRotation(const FQuat& PresentedRotation);
+
+	void ResetFixedStep();
+
+protected:
+	// Update locomotion at a fixed rate instead of once per frame, so hitches and low frame rates do not change the result.
+	UPROPERTY(EditDefaultsOnly, Category = "Locomotion|Fixed Step")
+	bool bUseFixedStep = false;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Locomotion|Fixed Step", meta = (ClampMin = "10", EditCondition = "bUseFixedStep"))
+	float FixedStepRate = 60.f;
+
+	// Steps run in a single frame at most, the rest of a longer hitch is dropped.
+	UPROPERTY(EditDefaultsOnly, Category = "Locomotion|Fixed Step", meta = (ClampMin = "1", EditCondition = "bUseFixedStep"))
+	int32 MaxFixedSteps = 4;
+
+	// Delta time of the running update, the frame delta unless the fixed step is used.
+	float LocomotionDeltaTime = 0.f;
+
+	float FixedStepAccumulator = 0.f;
+
+	// Real time since the essential values were last sampled.
+	float TimeSinceEssentialValues = 0.f;
+
+	FRotator PreviousStepRotation = FRotator::ZeroRotator;
+
+	// Rotation of the actor after the last step. Anything else found on the actor was set outside the fixed step and is taken over as is.
+	FRotator CurrentStepRotation = FRotator::ZeroRotator;
+#pragma endregion
+
 #pragma region State Events
 public:
 	virtual void OnMovementModeChanged(EMovementMode PrevMovementMode, uint8 PreviousCustomMode = 0) override;
@@ -173,9 +214,16 @@ public:
 public:
 	void GetMovementStates(struct FMovementStates& OutMovementStates) const;
 
+	// Restore all state enums, rotation caches and anim instance values to their spawn defaults
+	// without re-running construction or BeginPlay. Used when handing out pooled characters.
+	void ResetLocomotionState();
+
 protected:
 	void OnBeginPlay();
 
+	// Update states to use the initial desired values.
+	void ApplyDesiredStates();
+
 	// Use the Character Movement Mode changes to set the Movement States to the right values.
 	// This allows you to have a custom set of movement states
 	// but still use the functionality of the default character movement component.
@@ -188,6 +236,9 @@ protected:
 	void OnOverlayStateChanged(const ELSOverlayState& NewOverlayState);
 	void OnViewModeChanged(const ELSViewMode& NewViewMode);
 
+	// The movement component finished timing an action, e.g. the roll montage has played out.
+	void OnTimedActionEnded(ELSMovementAction EndedAction);
+
 protected:
 	UPROPERTY(EditDefaultsOnly, Category = "Locomotion|State")
 	ELSMovementState MovementState = ELSMovementState::None;
@@ -217,9 +268,19 @@ protected:
 
 #pragma region Movement System
 protected:
-	// Get movement data from the Movement Model Data table and set the Movement Data Struct.
+	// Get the shared movement model from the registry, streaming in the Movement Model Asset if one is set.
 	// This allows you to easily switch out movement behaviors.
 	void SetMovementModel();
+	void OnMovementModelReady(FLSMovementModelHandle Handle);
+	const FLSMovementModel* GetMovementModel() const;
+
+public:
+	FLSMovementModelHandle GetMovementModelHandle() const
+	{
+		return MovementModelHandle;
+	}
+
+protected:
 	void UpdateCharacterMovement();
 	void UpdateDynamicMovementSettings(const ELSGaitType& AllowGait);
 	void SetTargetMovementSettings();
@@ -236,14 +297,19 @@ protected:
 	virtual UAnimMontage* GetRollAnimation();
 
 protected:
-	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|Movement")
-	FMovementSettings_State MovementData;
-
 	UPROPERTY(EditDefaultsOnly, Category = "Locomotion|Movement")
 	FDataTableRowHandle MovementModel;
 
+	// Loaded asynchronously and preferred over the Movement Model row when set.
+	// Until it is ready the character keeps the movement component defaults.
+	UPROPERTY(EditDefaultsOnly, Category = "Locomotion|Movement")
+	TSoftObjectPtr<class ULSMovementModelAsset> MovementModelAsset;
+
 	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|Movement")
 	FMovementSettings CurMovementSettings;
+
+	// Shared with every character using the same Movement Model row.
+	FLSMovementModelHandle MovementModelHandle;
 #pragma endregion
 
 #pragma region Rotation System
@@ -276,6 +342,265 @@ protected:
 	float YawOffset = 0.f;
 #pragma endregion
 
+#pragma region Landing Prediction
+public:
+	const FLSLandingPrediction& GetLandingPrediction() const
+	{
+		return LandingPrediction;
+	}
+
+protected:
+	// Solve the ballistic arc towards the last confirmed landing height every frame,
+	// and confirm the landing point with one scheduled sweep that is only reissued when the arc drifts.
+	void UpdateLandingPrediction();
+	void RequestLandingSweep(const FVector& Location, const FVector& Velocity, float GravityZ);
+	void OnLandingSweepCompleted(FLSTraceTicket Ticket, const FLSTraceResult& Result);
+	void ResetLandingPrediction();
+
+	// Time until a body at StartZ moving at VelocityZ falls to TargetZ, false if the arc never reaches it.
+	static bool SolveTimeToHeight(double StartZ, double VelocityZ, double GravityZ, double TargetZ, float& OutTime);
+
+protected:
+	// Landings further away than this are not searched for.
+	UPROPERTY(EditDefaultsOnly, Category = "Locomotion|Landing")
+	float LandingPredictionMaxTime = 1.5f;
+
+	// The landing sweep is refreshed at most this often while the arc stays on course.
+	UPROPERTY(EditDefaultsOnly, Category = "Locomotion|Landing")
+	float LandingSweepInterval = 0.25f;
+
+	// Horizontal velocity change (air control, knockback) that invalidates the last sweep right away.
+	UPROPERTY(EditDefaultsOnly, Category = "Locomotion|Landing")
+	float LandingSweepVelocityTolerance = 50.f;
+
+	// Landing effects (breakfall montage, friction) are prepared this long before the predicted touchdown.
+	UPROPERTY(EditDefaultsOnly, Category = "Locomotion|Landing")
+	float LandingLeadTime = 0.3f;
+
+	FLSLandingPrediction LandingPrediction;
+	FLSTraceTicket LandingSweepTicket;
+	FVector LandingSweepVelocity = FVector::ZeroVector;
+	double LandingSweepTime = 0.0;
+
+	// Scheduled while in the air, applied in Landed.
+	bool bLandingScheduled = false;
+	bool bLandingBreakfall = false;
+	float LandingBrakingFriction = 0.f;
+#pragma endregion
+
+#pragma region Mantle System
+public:
+	// Mantle onto a ledge in front of the character if there is one, e.g. from the jump input.
+	// The ledge is checked in the next move, false if no mantle can be requested now.
+	bool TryMantle();
+
+protected:
+	// Have the next move check for a ledge. Only the locally controlled side requests, the server follows the client's move.
+	bool RequestMantle();
+
+	// Runs inside the move that carries the request, on the client and on the server.
+	void OnMantleRequested();
+
+	// Trace for a ledge the character can climb onto and start the mantle if one is found.
+	bool MantleCheck(const FLSMantleTraceSettings& TraceSettings);
+
+	// Hand the mantle path to the movement component and play the mantle montage if it is resident.
+	bool MantleStart(float MantleHeight, UPrimitiveComponent* LedgeComponent, const FTransform& LedgeTransform, ELSMovementAction MantleAction);
+
+	void StopMantle();
+
+	// Check if the capsule fits at the location, used to make sure there is room to stand on the ledge.
+	bool CapsuleHasRoomCheck(const FVector& TargetLocation, float HeightOffset, float RadiusOffset) const;
+
+protected:
+	UPROPERTY(EditDefaultsOnly, Category = "Locomotion|Mantle")
+	FLSMantleTraceSettings GroundedMantleTraceSettings;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Locomotion|Mantle")
+	FLSMantleTraceSettings FallingMantleTraceSettings;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Locomotion|Mantle")
+	FLSMantleAsset LowMantleAsset;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Locomotion|Mantle")
+	FLSMantleAsset HighMantleAsset;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Locomotion|Mantle")
+	TEnumAsByte<ECollisionChannel> MantleTraceChannel = ECC_Visibility;
+
+	// Ledges higher above the capsule than this use the High Mantle.
+	UPROPERTY(EditDefaultsOnly, Category = "Locomotion|Mantle")
+	float HighMantleMinHeight = 125.f;
+
+	// Ledges on objects moving faster than this are not mantled onto.
+	UPROPERTY(EditDefaultsOnly, Category = "Locomotion|Mantle")
+	float AcceptableLedgeVelocity = 10.f;
+#pragma endregion
+
+#pragma region Climbing
+public:
+	// Start climbing the surface in front of the character, e.g. from an input.
+	// The surface is looked for in the next move, false if no climb can be requested now.
+	bool TryClimb();
+
+	// Drop down from the climbed surface.
+	void StopClimbing();
+
+	const FLSClimbingIKSettings& GetClimbingIKSettings() const
+	{
+		return ClimbingIKSettings;
+	}
+
+protected:
+	// Mantle onto the ledge once climbing up runs out of surface.
+	void UpdateClimbing();
+
+	// Hand the character to the limb placement subsystem while climbing.
+	void SetClimbingIKRegistered(bool bRegistered);
+
+protected:
+	UPROPERTY(EditDefaultsOnly, Category = "Locomotion|Climbing")
+	FLSClimbingIKSettings ClimbingIKSettings;
+#pragma endregion
+
+#pragma region Animation Budget
+protected:
+	// Feed the animation budget allocator how much this mesh matters, from the distance to the closest view,
+	// whether it was rendered, and the Movement State. The locally controlled character is never throttled.
+	void UpdateAnimationSignificance(float ClosestViewDistance);
+
+	// Distance to the closest local player view, MAX_flt if there is none.
+	float GetClosestViewDistance() const;
+
+	void OnAnimationReduceWork(USkeletalMeshComponentBudgeted* Component, bool bReduce);
+
+protected:
+	// Significance falls off to 0 at this distance from the closest view.
+	UPROPERTY(EditDefaultsOnly, Category = "Locomotion|Animation Budget")
+	float AnimationSignificanceMaxDistance = 5000.f;
+
+	// Scale for meshes that were not rendered recently.
+	UPROPERTY(EditDefaultsOnly, Category = "Locomotion|Animation Budget")
+	float NotRenderedSignificanceScale = 0.25f;
+
+	// Scale for grounded meshes standing still, idles hide skipped frames well.
+	UPROPERTY(EditDefaultsOnly, Category = "Locomotion|Animation Budget")
+	float IdleSignificanceScale = 0.5f;
+#pragma endregion
+
+#pragma region Animation Sharing
+protected:
+	// Distant characters follow a shared pose of the Animation Sharing Manager instead of updating their own anim instance,
+	// and get it back once they come close again.
+	void UpdateAnimationSharing(float ClosestViewDistance);
+	void StartSharedAnimation();
+	void StopSharedAnimation();
+
+protected:
+	// Setup of the world's Animation Sharing Manager, which is created by the first character that needs it.
+	UPROPERTY(EditDefaultsOnly, Category = "Locomotion|Animation Sharing")
+	TObjectPtr<class UAnimationSharingSetup> AnimationSharingSetup;
+
+	// Characters further than this from every view switch to a shared pose.
+	UPROPERTY(EditDefaultsOnly, Category = "Locomotion|Animation Sharing")
+	float AnimationSharingDistance = 3000.f;
+
+	// ...and get their own anim instance back closer than this, which keeps them from flipping at the boundary.
+	UPROPERTY(EditDefaultsOnly, Category = "Locomotion|Animation Sharing")
+	float AnimationSharingPromoteDistance = 2500.f;
+
+	bool bUsesSharedAnimation = false;
+#pragma endregion
+
+#pragma region Mass LOD
+public:
+	// Only grounded AI characters that are not in the middle of an action are handed over to Mass.
+	bool CanConvertToMassEntity() const;
+
+	// Capture the locomotion state for the Mass entity that replaces this character, and apply it back when the entity turns into a character again.
+	void GetLocomotionFragment(struct FLSLocomotionFragment& OutFragment) const;
+	void ApplyLocomotionFragment(const struct FLSLocomotionFragment& Fragment);
+
+protected:
+	// Let the Mass LOD subsystem turn this character into a Mass entity when it is far from every view.
+	UPROPERTY(EditDefaultsOnly, Category = "Locomotion|Mass LOD")
+	bool bAllowMassLOD = false;
+#pragma endregion
+
+#pragma region Crowd Avoidance
+public:
+	// Only AI characters walking on the ground are steered, player characters are avoided but keep their input.
+	bool ShouldSteerForAvoidance() const;
+
+	float GetAvoidanceWeight() const
+	{
+		return AvoidanceWeight;
+	}
+
+protected:
+	// Register with the avoidance subsystem, to be avoided by AI characters and, when AI controlled, to steer around the others.
+	UPROPERTY(EditDefaultsOnly, Category = "Locomotion|Crowd Avoidance")
+	bool bUseLSAvoidance = false;
+
+	// Scale of the avoidance steering added to the movement input.
+	UPROPERTY(EditDefaultsOnly, Category = "Locomotion|Crowd Avoidance", meta = (ClampMin = "0"))
+	float AvoidanceWeight = 1.f;
+#pragma endregion
+
+#pragma region Input Recording
+public:
+	// The movement input pending for this frame as the forward and right axes, with the control rotation and the desired states.
+	void GetRecordedInput(struct FLSInputFrame& OutFrame) const;
+
+	// Replace this frame's movement input, control rotation and desired states with recorded ones.
+	void ApplyRecordedInput(const struct FLSInputFrame& Frame);
+
+	void GetRecordedState(struct FLSStateFrame& OutState) const;
+
+	// Move the character to where a recording starts and restore its states.
+	void ApplyRecordedState(const struct FLSStateFrame& State);
+#pragma endregion
+
+#pragma region Overlay Layers
+protected:
+	// Stream in the linked anim layer for the current Overlay State.
+	// The previous layer stays linked until the new one is ready.
+	void UpdateOverlayLayer();
+	void OnOverlayLayerReady(TSubclassOf<UAnimInstance> LayerClass, TSoftClassPtr<UAnimInstance> RequestedLayer);
+	void ReleaseOverlayLayers();
+
+protected:
+	UPROPERTY(EditDefaultsOnly, Category = "Locomotion|Overlay")
+	TObjectPtr<class ULSOverlayLayerSet> OverlayLayerSet;
+
+	TSoftClassPtr<UAnimInstance> ActiveOverlayLayer;
+	TSoftClassPtr<UAnimInstance> PendingOverlayLayer;
+#pragma endregion
+
+#pragma region Action Montages
+protected:
+	// Preload the montages of every action the current Movement State can trigger and release the rest,
+	// e.g. In Air can lead to a breakfall roll or a mantle. Also called when the Overlay State changes.
+	void UpdatePreloadedActionMontages();
+
+	// Get the montage for the action if it is resident. Never loads synchronously.
+	UAnimMontage* GetActionMontage(ELSMovementAction Action) const;
+
+	static TArray<ELSMovementAction, TInlineAllocator<4>> GetPredictedActions(ELSMovementState State);
+
+protected:
+	UPROPERTY(EditDefaultsOnly, Category = "Locomotion|Actions")
+	TObjectPtr<class ULSActionMontageSet> ActionMontageSet;
+
+	struct FPreloadedMontage
+	{
+		TSoftObjectPtr<UAnimMontage> Montage;
+		TSharedPtr<struct FStreamableHandle> Handle;
+	};
+
+	TMap<ELSMovementAction, FPreloadedMontage> PreloadedActionMontages;
+#pragma endregion
+
 #pragma region Utility
 	float GetAnimCurveValue(const FName& CurveName) const;
 	FVector GetCapsuleBaseLocation(float ZOffset) const;
@@ -1,3 +1,656 @@
 // Copyright BanMing
 
 #include "Components/LSCharacterMovementComponent.h"
+
+#include "Components/CapsuleComponent.h"
+#include "Components/LSRootMotionSource_Mantle.h"
+#include "Data/LocomotionRules.h"
+#include "Engine/World.h"
+#include "GameFramework/Character.h"
+
+const FName ULSCharacterMovementComponent::MantleRootMotionName(TEXT("LSMantle"));
+
+void FLSSavedMove::Clear()
+{
+	Super::Clear();
+	bWantsToMantle = false;
+	bWantsToClimb = false;
+	RotationMode = ELSRotationMode::LookingDirection;
+	StartLandingFrictionTimeRemaining = 0.f;
+	StartBrakingFrictionFactor = 0.f;
+	StartRestoreBrakingFrictionFactor = 0.f;
+	bStartLandingFrictionActive = false;
+	StartTimedAction = ELSMovementAction::None;
+	StartTimedActionElapsed = 0.f;
+	StartTimedActionDuration = 0.f;
+	StartClimbLedgeHeldTime = 0.f;
+	bStartReachedClimbLedge = false;
+}
+
+uint8 FLSSavedMove::GetCompressedFlags() const
+{
+	uint8 Flags = Super::GetCompressedFlags();
+	if (bWantsToMantle)
+	{
+		Flags |= FLAG_Custom_0;
+	}
+	if (bWantsToClimb)
+	{
+		Flags |= FLAG_Custom_1;
+	}
+	if (static_cast<uint8>(RotationMode) & 0x1)
+	{
+		Flags |= FLAG_Custom_2;
+	}
+	if (static_cast<uint8>(RotationMode) & 0x2)
+	{
+		Flags |= FLAG_Custom_3;
+	}
+	return Flags;
+}
+
+void FLSSavedMove::SetMoveFor(ACharacter* Character, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData)
+{
+	Super::SetMoveFor(Character, InDeltaTime, NewAccel, ClientData);
+
+	const ULSCharacterMovementComponent* MovementComp = Cast<ULSCharacterMovementComponent>(Character->GetCharacterMovement());
+	bWantsToMantle = MovementComp && MovementComp->IsMantleRequested();
+	bWantsToClimb = MovementComp && MovementComp->IsClimbRequested();
+	RotationMode = MovementComp ? MovementComp->MovementCurveRotationMode : ELSRotationMode::LookingDirection;
+
+	// Saved before the move is performed.
+	if (MovementComp)
+	{
+		SaveTimedEffects(*MovementComp);
+	}
+}
+
+void FLSSavedMove::PrepMoveFor(ACharacter* Character)
+{
+	Super::PrepMoveFor(Character);
+
+	if (ULSCharacterMovementComponent* MovementComp = Cast<ULSCharacterMovementComponent>(Character->GetCharacterMovement()))
+	{
+		MovementComp->bWantsToMantle = bWantsToMantle;
+		MovementComp->bWantsToClimb = bWantsToClimb;
+		MovementComp->MovementCurveRotationMode = RotationMode;
+		RestoreTimedEffects(*MovementComp);
+	}
+}
+
+void FLSSavedMove::CombineWith(const FSavedMove_Character* OldMove, ACharacter* InCharacter, APlayerController* PC, const FVector& OldStartLocation)
+{
+	Super::CombineWith(OldMove, InCharacter, PC, OldStartLocation);
+
+	// The combined move is performed again from the start of the old one.
+	const FLSSavedMove* OldLSMove = static_cast<const FLSSavedMove*>(OldMove);
+	ULSCharacterMovementComponent* MovementComp = Cast<ULSCharacterMovementComponent>(InCharacter->GetCharacterMovement());
+	if (MovementComp)
+	{
+		OldLSMove->RestoreTimedEffects(*MovementComp);
+		SaveTimedEffects(*MovementComp);
+	}
+}
+
+void FLSSavedMove::SaveTimedEffects(const ULSCharacterMovementComponent& MovementComp)
+{
+	StartLandingFrictionTimeRemaining = MovementComp.LandingFrictionTimeRemaining;
+	StartBrakingFrictionFactor = MovementComp.BrakingFrictionFactor;
+	StartRestoreBrakingFrictionFactor = MovementComp.RestoreBrakingFrictionFactor;
+	bStartLandingFrictionActive = MovementComp.bLandingFrictionActive;
+	StartTimedAction = MovementComp.TimedAction;
+	StartTimedActionElapsed = MovementComp.TimedActionElapsed;
+	StartTimedActionDuration = MovementComp.TimedActionDuration;
+	StartClimbLedgeHeldTime = MovementComp.ClimbLedgeHeldTime;
+	bStartReachedClimbLedge = MovementComp.bReachedClimbLedge;
+}
+
+void FLSSavedMove::RestoreTimedEffects(ULSCharacterMovementComponent& MovementComp) const
+{
+	MovementComp.LandingFrictionTimeRemaining = StartLandingFrictionTimeRemaining;
+	MovementComp.BrakingFrictionFactor = StartBrakingFrictionFactor;
+	MovementComp.RestoreBrakingFrictionFactor = StartRestoreBrakingFrictionFactor;
+	MovementComp.bLandingFrictionActive = bStartLandingFrictionActive;
+	MovementComp.TimedAction = StartTimedAction;
+	MovementComp.TimedActionElapsed = StartTimedActionElapsed;
+	MovementComp.TimedActionDuration = StartTimedActionDuration;
+	MovementComp.ClimbLedgeHeldTime = StartClimbLedgeHeldTime;
+	MovementComp.bReachedClimbLedge = bStartReachedClimbLedge;
+}
+
+FLSNetworkPredictionData_Client::FLSNetworkPredictionData_Client(const UCharacterMovementComponent& ClientMovement)
+	: Super(ClientMovement)
+{
+}
+
+FSavedMovePtr FLSNetworkPredictionData_Client::AllocateNewMove()
+{
+	return FSavedMovePtr(new FLSSavedMove());
+}
+
+void ULSCharacterMovementComponent::StartLandingFriction(float Friction, float Duration)
+{
+	if (!bLandingFrictionActive)
+	{
+		RestoreBrakingFrictionFactor = BrakingFrictionFactor;
+		bLandingFrictionActive = true;
+	}
+
+	BrakingFrictionFactor = Friction;
+	LandingFrictionTimeRemaining = FMath::Max(Duration, 0.f);
+}
+
+void ULSCharacterMovementComponent::StopLandingFriction()
+{
+	if (bLandingFrictionActive)
+	{
+		BrakingFrictionFactor = RestoreBrakingFrictionFactor;
+		bLandingFrictionActive = false;
+		LandingFrictionTimeRemaining = 0.f;
+	}
+}
+
+void ULSCharacterMovementComponent::StartTimedAction(ELSMovementAction Action, float Duration)
+{
+	TimedAction = Action;
+	TimedActionElapsed = 0.f;
+	TimedActionDuration = FMath::Max(Duration, 0.f);
+}
+
+void ULSCharacterMovementComponent::StopTimedAction()
+{
+	TimedAction = ELSMovementAction::None;
+	TimedActionElapsed = 0.f;
+	TimedActionDuration = 0.f;
+	PendingEndedAction = ELSMovementAction::None;
+}
+
+float ULSCharacterMovementComponent::GetTimedActionProgress() const
+{
+	if (TimedAction == ELSMovementAction::None)
+	{
+		return 0.f;
+	}
+
+	if (IsMantleAction(TimedAction))
+	{
+		const FRootMotionSource* MantleSource = FindMantleSource();
+		return MantleSource && MantleSource->Duration > 0.f ? FMath::Clamp(MantleSource->GetTime() / MantleSource->Duration, 0.f, 1.f) : 1.f;
+	}
+
+	if (TimedActionDuration <= 0.f)
+	{
+		return 1.f;
+	}
+
+	return FMath::Clamp(TimedActionElapsed / TimedActionDuration, 0.f, 1.f);
+}
+
+void ULSCharacterMovementComponent::StartMantle(const FLSMantleParams& MantleParams, ELSMovementAction MantleAction, float Duration)
+{
+	StopMantle();
+
+	TSharedPtr<FLSRootMotionSource_Mantle> MantleSource = MakeShared<FLSRootMotionSource_Mantle>();
+	MantleSource->InstanceName = MantleRootMotionName;
+	MantleSource->Duration = Duration;
+	MantleSource->MantleParams = MantleParams;
+	ApplyRootMotionSource(MantleSource);
+
+	SetMovementMode(MOVE_Flying);
+	StartTimedAction(MantleAction, Duration);
+}
+
+void ULSCharacterMovementComponent::StopMantle()
+{
+	if (IsMantling())
+	{
+		RemoveRootMotionSource(MantleRootMotionName);
+	}
+}
+
+bool ULSCharacterMovementComponent::IsMantling()
+{
+	return GetRootMotionSource(MantleRootMotionName).IsValid();
+}
+
+const FRootMotionSource* ULSCharacterMovementComponent::FindMantleSource() const
+{
+	for (const TSharedPtr<FRootMotionSource>& Source : CurrentRootMotion.RootMotionSources)
+	{
+		if (Source.IsValid() && Source->InstanceName == MantleRootMotionName)
+		{
+			return Source.Get();
+		}
+	}
+	return nullptr;
+}
+
+void ULSCharacterMovementComponent::UpdateMantleEnd()
+{
+	if (!IsMantleAction(TimedAction))
+	{
+		return;
+	}
+
+	// The root motion source's time is the one corrections and replays restore, so it alone decides when the mantle is over.
+	const FRootMotionSource* MantleSource = FindMantleSource();
+	if (MantleSource && !MantleSource->Status.HasFlag(ERootMotionSourceStatusFlags::Finished) && (MantleSource->Duration < 0.f || MantleSource->GetTime() < MantleSource->Duration))
+	{
+		return;
+	}
+
+	const ELSMovementAction EndedAction = TimedAction;
+	StopMantle();
+	StopTimedAction();
+	PendingEndedAction = EndedAction;
+	if (MovementMode == MOVE_Flying)
+	{
+		SetMovementMode(MOVE_Walking);
+	}
+}
+
+void ULSCharacterMovementComponent::RequestMantle()
+{
+	bWantsToMantle = true;
+}
+
+FNetworkPredictionData_Client* ULSCharacterMovementComponent::GetPredictionData_Client() const
+{
+	if (ClientPredictionData == nullptr)
+	{
+		ULSCharacterMovementComponent* MutableThis = const_cast<ULSCharacterMovementComponent*>(this);
+		MutableThis->ClientPredictionData = new FLSNetworkPredictionData_Client(*this);
+	}
+	return ClientPredictionData;
+}
+
+#pragma region Movement Curves
+void ULSCharacterMovementComponent::SetMovementCurves(const FLSMovementModelHandle& Model, ELSRotationMode RotationMode)
+{
+	if (MovementModel != Model)
+	{
+		MovementModel = Model;
+	}
+	MovementCurveRotationMode = RotationMode;
+}
+
+void ULSCharacterMovementComponent::ApplyMovementCurves()
+{
+	const FLSMovementModel* Model = MovementModel.IsValid() ? MovementModel->Get() : nullptr;
+	if (Model == nullptr)
+	{
+		return;
+	}
+
+	const ELSStanceType Stance = IsCrouching() ? ELSStanceType::Crouching : ELSStanceType::Standing;
+	const FLSBakedMovementCurves& Curves = Model->GetBakedCurves(MovementCurveRotationMode, Stance);
+	if (!Curves.IsValid())
+	{
+		return;
+	}
+
+	const float MappedSpeed = FLSLocomotionRules::GetMappedSpeed(Velocity.Size2D(), Model->GetSettings(MovementCurveRotationMode, Stance));
+	const FVector CurveValue = Curves.SampleMovement(MappedSpeed);
+	MaxAcceleration = CurveValue.X;
+	BrakingDecelerationWalking = CurveValue.Y;
+	GroundFriction = CurveValue.Z;
+}
+#pragma endregion
+
+#pragma region Climbing
+void ULSCharacterMovementComponent::RequestClimb()
+{
+	bWantsToClimb = true;
+}
+
+bool ULSCharacterMovementComponent::TryStartClimbing()
+{
+	if (CharacterOwner == nullptr || (MovementMode != MOVE_Walking && MovementMode != MOVE_NavWalking && MovementMode != MOVE_Falling))
+	{
+		return false;
+	}
+
+	FHitResult Hit;
+	if (!TraceClimbSurface(UpdatedComponent->GetForwardVector(), Hit) || !IsClimbableSurface(Hit))
+	{
+		return false;
+	}
+
+	SetClimbSurface(Hit);
+	SetMovementMode(MOVE_Custom, static_cast<uint8>(ELSCustomMovementMode::Climbing));
+	return true;
+}
+
+void ULSCharacterMovementComponent::StopClimbing()
+{
+	if (IsClimbing())
+	{
+		SetMovementMode(MOVE_Falling);
+	}
+}
+
+bool ULSCharacterMovementComponent::GetClimbSurface(FVector& OutPoint, FVector& OutNormal) const
+{
+	if (!IsClimbing() || !ClimbSurface.bValid)
+	{
+		return false;
+	}
+
+	OutPoint = ClimbSurface.ImpactPoint;
+	OutNormal = ClimbSurface.Normal;
+	return true;
+}
+
+FVector ULSCharacterMovementComponent::GetClimbUpVector() const
+{
+	return ClimbSurface.bValid ? FVector::VectorPlaneProject(FVector::UpVector, ClimbSurface.Normal).GetSafeNormal() : FVector::UpVector;
+}
+
+FVector ULSCharacterMovementComponent::GetClimbRightVector() const
+{
+	return ClimbSurface.bValid ? FVector::CrossProduct(GetClimbUpVector(), -ClimbSurface.Normal).GetSafeNormal() : UpdatedComponent->GetRightVector();
+}
+
+float ULSCharacterMovementComponent::GetMaxSpeed() const
+{
+	return IsClimbing() ? MaxClimbSpeed : Super::GetMaxSpeed();
+}
+
+float ULSCharacterMovementComponent::GetMaxBrakingDeceleration() const
+{
+	return IsClimbing() ? BrakingDecelerationClimbing : Super::GetMaxBrakingDeceleration();
+}
+
+void ULSCharacterMovementComponent::OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode)
+{
+	Super::OnMovementModeChanged(PreviousMovementMode, PreviousCustomMode);
+
+	bReachedClimbLedge = false;
+	bPendingClimbStart = false;
+
+	if (IsClimbing())
+	{
+		Velocity = FVector::ZeroVector;
+	}
+	else if (PreviousMovementMode == MOVE_Custom && PreviousCustomMode == static_cast<uint8>(ELSCustomMovementMode::Climbing))
+	{
+		ClimbSurface = FClimbSurface();
+	}
+}
+
+void ULSCharacterMovementComponent::OnMovementUpdated(float DeltaSeconds, const FVector& OldLocation, const FVector& OldVelocity)
+{
+	Super::OnMovementUpdated(DeltaSeconds, OldLocation, OldVelocity);
+
+	if (bPendingClimbStart)
+	{
+		bPendingClimbStart = false;
+		if (MovementMode == MOVE_Falling)
+		{
+			SetClimbSurface(PendingClimbHit);
+			SetMovementMode(MOVE_Custom, static_cast<uint8>(ELSCustomMovementMode::Climbing));
+		}
+	}
+}
+
+void ULSCharacterMovementComponent::PhysCustom(float DeltaTime, int32 Iterations)
+{
+	if (CustomMovementMode == static_cast<uint8>(ELSCustomMovementMode::Climbing))
+	{
+		PhysClimbing(DeltaTime, Iterations);
+	}
+
+	Super::PhysCustom(DeltaTime, Iterations);
+}
+
+void ULSCharacterMovementComponent::HandleImpact(const FHitResult& Hit, float TimeSlice, const FVector& MoveDelta)
+{
+	Super::HandleImpact(Hit, TimeSlice, MoveDelta);
+
+	// Reuses the hit of the falling move, so catching a wall costs no trace.
+	if (bClimbWhenFallingIntoSurface && MovementMode == MOVE_Falling && !bPendingClimbStart && IsClimbableSurface(Hit) && (GetCurrentAcceleration() | -Hit.ImpactNormal) > 0.f)
+	{
+		PendingClimbHit = Hit;
+		bPendingClimbStart = true;
+	}
+}
+
+void ULSCharacterMovementComponent::PhysClimbing(float DeltaTime, int32 Iterations)
+{
+	if (DeltaTime < MIN_TICK_TIME)
+	{
+		return;
+	}
+
+	const FVector ProbeDirection = ClimbSurface.bValid ? -ClimbSurface.Normal : UpdatedComponent->GetForwardVector();
+	if (!UpdateClimbSurface(ProbeDirection))
+	{
+		// Out of surface while climbing up: hold on at the ledge for a moment so the owner can mantle onto it.
+		if (Velocity.Z > 0.f || GetCurrentAcceleration().Z > 0.f)
+		{
+			// Timed with the move's delta time. Saved moves restore the held time they started with, so replayed moves
+			// and the server's run of them let go on the same move.
+			if (!bReachedClimbLedge)
+			{
+				bReachedClimbLedge = true;
+				ClimbLedgeHeldTime = 0.f;
+			}
+
+			if (ClimbLedgeHeldTime < ClimbLedgeGraceTime)
+			{
+				ClimbLedgeHeldTime += DeltaTime;
+				Velocity = FVector::ZeroVector;
+				return;
+			}
+		}
+
+		StopClimbing();
+		StartNewPhysics(DeltaTime, Iterations);
+		return;
+	}
+	bReachedClimbLedge = false;
+
+	RestorePreAdditiveRootMotionVelocity();
+	if (!HasAnimRootMotion() && !CurrentRootMotion.HasOverrideVelocity())
+	{
+		CalcVelocity(DeltaTime, 0.f, false, GetMaxBrakingDeceleration());
+	}
+	ApplyRootMotionToVelocity(DeltaTime);
+
+	// Only move along the surface.
+	Velocity = FVector::VectorPlaneProject(Velocity, ClimbSurface.Normal);
+
+	++Iterations;
+	const FVector OldLocation = UpdatedComponent->GetComponentLocation();
+
+	// Face the surface and keep the capsule at a fixed distance from its plane as part of the same move.
+	const FQuat TargetRotation = FRotationMatrix::MakeFromX(-ClimbSurface.Normal.GetSafeNormal2D()).ToQuat();
+	const FQuat NewRotation = FMath::QInterpTo(UpdatedComponent->GetComponentQuat(), TargetRotation, DeltaTime, ClimbRotationSpeed);
+	const float SurfaceDistance = (OldLocation - ClimbSurface.ImpactPoint) | ClimbSurface.Normal;
+	const float DesiredDistance = CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleRadius() + ClimbSurfaceGap;
+	const FVector Delta = Velocity * DeltaTime + ClimbSurface.Normal * (DesiredDistance - SurfaceDistance);
+
+	FHitResult Hit(1.f);
+	SafeMoveUpdatedComponent(Delta, NewRotation, true, Hit);
+	if (Hit.Time < 1.f)
+	{
+		// Climbing down onto walkable ground ends the climb.
+		if (Velocity.Z < 0.f && IsWalkable(Hit))
+		{
+			SetMovementMode(MOVE_Walking);
+			return;
+		}
+
+		// Running into a differently angled surface (inner corner, bulge) invalidates the cached one without an extra trace.
+		if ((Hit.ImpactNormal | ClimbSurface.Normal) < FMath::Cos(FMath::DegreesToRadians(ClimbProbeMaxNormalAngle)))
+		{
+			ClimbSurface.bValid = false;
+		}
+
+		HandleImpact(Hit, DeltaTime, Delta);
+		SlideAlongSurface(Delta, 1.f - Hit.Time, Hit.Normal, Hit, true);
+	}
+
+	if (!HasAnimRootMotion() && !CurrentRootMotion.HasOverrideVelocity())
+	{
+		Velocity = FVector::VectorPlaneProject((UpdatedComponent->GetComponentLocation() - OldLocation) / DeltaTime, ClimbSurface.Normal);
+	}
+}
+
+bool ULSCharacterMovementComponent::UpdateClimbSurface(const FVector& ProbeDirection)
+{
+	const UPrimitiveComponent* SurfaceComponent = ClimbSurface.Component.Get();
+	if (ClimbSurface.bValid && SurfaceComponent && SurfaceComponent->GetComponentVelocity().IsNearlyZero() &&
+		FVector::DistSquared(UpdatedComponent->GetComponentLocation(), ClimbSurface.ProbeLocation) < FMath::Square(ClimbProbeReuseDistance))
+	{
+		return true;
+	}
+
+	FHitResult Hit;
+	if (!TraceClimbSurface(ProbeDirection, Hit) || !IsClimbableSurface(Hit))
+	{
+		ClimbSurface.bValid = false;
+		return false;
+	}
+
+	SetClimbSurface(Hit);
+	return true;
+}
+
+bool ULSCharacterMovementComponent::TraceClimbSurface(const FVector& Direction, FHitResult& OutHit) const
+{
+	const FVector Start = UpdatedComponent->GetComponentLocation();
+	const FVector End = Start + Direction * (CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleRadius() + ClimbReachDistance);
+	const FCollisionQueryParams Params(SCENE_QUERY_STAT(ClimbSurface), false, CharacterOwner);
+	return GetWorld()->LineTraceSingleByChannel(OutHit, Start, End, ClimbTraceChannel, Params);
+}
+
+bool ULSCharacterMovementComponent::IsClimbableSurface(const FHitResult& Hit) const
+{
+	return Hit.bBlockingHit && FMath::Abs(Hit.ImpactNormal.Z) <= ClimbMaxSurfaceNormalZ;
+}
+
+void ULSCharacterMovementComponent::SetClimbSurface(const FHitResult& Hit)
+{
+	ClimbSurface.ImpactPoint = Hit.ImpactPoint;
+	ClimbSurface.Normal = Hit.ImpactNormal;
+	ClimbSurface.ProbeLocation = UpdatedComponent->GetComponentLocation();
+	ClimbSurface.Component = Hit.GetComponent();
+	ClimbSurface.bValid = true;
+}
+#pragma endregion
+
+void ULSCharacterMovementComponent::PerformMovement(float DeltaTime)
+{
+	UpdateTimedEffects(DeltaTime);
+	Super::PerformMovement(DeltaTime);
+
+	// Normally already done after the move, unless it was cut short.
+	BroadcastEndedAction();
+}
+
+void ULSCharacterMovementComponent::UpdateFromCompressedFlags(uint8 Flags)
+{
+	Super::UpdateFromCompressedFlags(Flags);
+	bWantsToMantle = (Flags & FSavedMove_Character::FLAG_Custom_0) != 0;
+	bWantsToClimb = (Flags & FSavedMove_Character::FLAG_Custom_1) != 0;
+	// The two bits also fit a value no rotation mode has, which only a broken or cheating client sends.
+	const uint8 RotationModeBits = ((Flags & FSavedMove_Character::FLAG_Custom_2) != 0 ? 0x1 : 0) | ((Flags & FSavedMove_Character::FLAG_Custom_3) != 0 ? 0x2 : 0);
+	MovementCurveRotationMode = RotationModeBits <= static_cast<uint8>(ELSRotationMode::Aiming) ? static_cast<ELSRotationMode>(RotationModeBits) : ELSRotationMode::LookingDirection;
+}
+
+void ULSCharacterMovementComponent::UpdateCharacterStateBeforeMovement(float DeltaSeconds)
+{
+	Super::UpdateCharacterStateBeforeMovement(DeltaSeconds);
+
+	// After the crouch update, so the curves are the ones of the stance the move is in.
+	ApplyMovementCurves();
+
+	// Starting here puts the mantle's root motion source into this very move, on the client and on the server.
+	if (bWantsToMantle)
+	{
+		bWantsToMantle = false;
+		if (TimedAction == ELSMovementAction::None && !IsMantling())
+		{
+			OnMantleRequested.ExecuteIfBound();
+		}
+	}
+
+	if (bWantsToClimb)
+	{
+		bWantsToClimb = false;
+		if (TimedAction == ELSMovementAction::None)
+		{
+			TryStartClimbing();
+		}
+	}
+}
+
+void ULSCharacterMovementComponent::UpdateCharacterStateAfterMovement(float DeltaSeconds)
+{
+	Super::UpdateCharacterStateAfterMovement(DeltaSeconds);
+	UpdateMantleEnd();
+	BroadcastEndedAction();
+}
+
+void ULSCharacterMovementComponent::PhysicsRotation(float DeltaTime)
+{
+	// The mantle path also carries the rotation, which root motion sources do not apply on their own.
+	const TSharedPtr<FRootMotionSource> Source = GetRootMotionSource(MantleRootMotionName);
+	if (Source.IsValid() && Source->GetScriptStruct() == FLSRootMotionSource_Mantle::StaticStruct())
+	{
+		FVector Location;
+		FQuat Rotation;
+		static_cast<const FLSRootMotionSource_Mantle*>(Source.Get())->MantleParams.Evaluate(Source->GetTime(), Location, Rotation);
+		MoveUpdatedComponent(FVector::ZeroVector, Rotation, false);
+		return;
+	}
+
+	Super::PhysicsRotation(DeltaTime);
+}
+
+void ULSCharacterMovementComponent::SimulatedTick(float DeltaSeconds)
+{
+	UpdateTimedEffects(DeltaSeconds);
+	Super::SimulatedTick(DeltaSeconds);
+	UpdateMantleEnd();
+	BroadcastEndedAction();
+}
+
+void ULSCharacterMovementComponent::UpdateTimedEffects(float DeltaTime)
+{
+	// Advanced by the move's own delta time. Saved moves restore the values they started with, so a replayed move starts from
+	// the same remaining time as the server's run of it and ends the effects on the same move.
+	if (bLandingFrictionActive)
+	{
+		LandingFrictionTimeRemaining -= DeltaTime;
+		if (LandingFrictionTimeRemaining <= 0.f)
+		{
+			StopLandingFriction();
+		}
+	}
+
+	// Mantles end with their root motion source, see UpdateMantleEnd.
+	if (TimedAction != ELSMovementAction::None && !IsMantleAction(TimedAction))
+	{
+		TimedActionElapsed += DeltaTime;
+		if (TimedActionElapsed >= TimedActionDuration)
+		{
+			// Clear first, the callback may start the next action.
+			const ELSMovementAction EndedAction = TimedAction;
+			StopTimedAction();
+			PendingEndedAction = EndedAction;
+		}
+	}
+}
+
+void ULSCharacterMovementComponent::BroadcastEndedAction()
+{
+	if (PendingEndedAction != ELSMovementAction::None)
+	{
+		const ELSMovementAction EndedAction = PendingEndedAction;
+		PendingEndedAction = ELSMovementAction::None;
+		OnTimedActionEnded.ExecuteIfBound(EndedAction);
+	}
+}
+
@@ -3,15 +3,279 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Data/LocomotionTypes.h"
+#include "Data/MovementModelRegistry.h"
 #include "GameFramework/CharacterMovementComponent.h"
 
+struct FLSMantleParams;
+
 #include "LSCharacterMovementComponent.generated.h"
 
+DECLARE_DELEGATE_OneParam(FOnTimedActionEnded, ELSMovementAction);
+DECLARE_DELEGATE(FOnMantleRequested);
+
+// Saved move carrying the locomotion system's requests, so the client's prediction and the server start them in the same move.
+class LOCOMOTIONSYSTEM_API FLSSavedMove : public FSavedMove_Character
+{
+public:
+	typedef FSavedMove_Character Super;
+
+	virtual void Clear() override;
+	virtual uint8 GetCompressedFlags() const override;
+	virtual void SetMoveFor(ACharacter* Character, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData) override;
+	virtual void PrepMoveFor(ACharacter* Character) override;
+	virtual void CombineWith(const FSavedMove_Character* OldMove, ACharacter* InCharacter, APlayerController* PC, const FVector& OldStartLocation) override;
+
+	uint8 bWantsToMantle : 1;
+	uint8 bWantsToClimb : 1;
+
+	// Selects the movement curves of the move, sent in FLAG_Custom_2 and FLAG_Custom_3.
+	ELSRotationMode RotationMode = ELSRotationMode::LookingDirection;
+
+	// Timed effects and the climb ledge grace as they were when the move started, a replay of the move starts from them again.
+	float StartLandingFrictionTimeRemaining = 0.f;
+	float StartBrakingFrictionFactor = 0.f;
+	float StartRestoreBrakingFrictionFactor = 0.f;
+	bool bStartLandingFrictionActive = false;
+	ELSMovementAction StartTimedAction = ELSMovementAction::None;
+	float StartTimedActionElapsed = 0.f;
+	float StartTimedActionDuration = 0.f;
+	float StartClimbLedgeHeldTime = 0.f;
+	bool bStartReachedClimbLedge = false;
+
+private:
+	void SaveTimedEffects(const class ULSCharacterMovementComponent& MovementComp);
+	void RestoreTimedEffects(class ULSCharacterMovementComponent& MovementComp) const;
+};
+
+class LOCOMOTIONSYSTEM_API FLSNetworkPredictionData_Client : public FNetworkPredictionData_Client_Character
+{
+public:
+	typedef FNetworkPredictionData_Client_Character Super;
+
+	explicit FLSNetworkPredictionData_Client(const UCharacterMovementComponent& ClientMovement);
+
+	virtual FSavedMovePtr AllocateNewMove() override;
+};
+
 /**
- *
+ * Character movement with the locomotion system's timed effects (landing friction, roll and mantle durations)
+ * kept as remaining move time that each move advances, instead of per character timers, latent actions or timelines.
  */
 UCLASS()
 class LOCOMOTIONSYSTEM_API ULSCharacterMovementComponent : public UCharacterMovementComponent
 {
 	GENERATED_BODY()
+
+	friend class FLSSavedMove;
+
+public:
+	// Raise the braking friction for Duration seconds, then restore the value it had before.
+	// Starting it again while active only moves the end time, like a retriggerable delay.
+	void StartLandingFriction(float Friction, float Duration);
+	void StopLandingFriction();
+
+	// Track an action lasting Duration seconds of move time. OnTimedActionEnded fires after the move it ends in, outside of the move itself.
+	// Mantles are not timed here, they end when their root motion source finishes.
+	void StartTimedAction(ELSMovementAction Action, float Duration);
+
+	// Stop the action without firing OnTimedActionEnded.
+	void StopTimedAction();
+
+	ELSMovementAction GetTimedAction() const
+	{
+		return TimedAction;
+	}
+
+	// Normalized progress of the timed action, 0 when there is none.
+	float GetTimedActionProgress() const;
+
+	FOnTimedActionEnded OnTimedActionEnded;
+
+	// Move the capsule along the mantle path with a root motion source, tracked as the Mantle action until the source finishes.
+	// Flying is used meanwhile so no floor checks or gravity interfere, walking resumes when the action ends.
+	void StartMantle(const FLSMantleParams& MantleParams, ELSMovementAction MantleAction, float Duration);
+	void StopMantle();
+	bool IsMantling();
+
+	// Ask for a mantle check in the next move. Sent to the server with the move, OnMantleRequested runs the check on both sides.
+	void RequestMantle();
+
+	bool IsMantleRequested() const
+	{
+		return bWantsToMantle;
+	}
+
+	FOnMantleRequested OnMantleRequested;
+
+	static const FName MantleRootMotionName;
+
+	virtual FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+
+#pragma region Movement Curves
+public:
+	// Model the acceleration, braking deceleration and ground friction of every move are sampled from, at the speed the move starts with.
+	// The curves are looked up in the move for the stance it is crouched in and the rotation mode it is sent with,
+	// so client prediction, replays and the server sample the same curves.
+	void SetMovementCurves(const FLSMovementModelHandle& Model, ELSRotationMode RotationMode);
+
+protected:
+	void ApplyMovementCurves();
+
+protected:
+	// The entry rather than the model, hot reloading swaps the model inside it.
+	FLSMovementModelHandle MovementModel;
+
+	// Set by the owner for new moves, from the move data for received and replayed ones.
+	ELSRotationMode MovementCurveRotationMode = ELSRotationMode::LookingDirection;
+#pragma endregion
+
+#pragma region Climbing
+public:
+	// Ask to start climbing in the next move. Sent to the server with the move, both sides look for the surface in it.
+	void RequestClimb();
+
+	bool IsClimbRequested() const
+	{
+		return bWantsToClimb;
+	}
+
+	// Let go of the surface and fall.
+	void StopClimbing();
+
+	bool IsClimbing() const
+	{
+		return MovementMode == MOVE_Custom && CustomMovementMode == static_cast<uint8>(ELSCustomMovementMode::Climbing);
+	}
+
+	// Set while climbing up has run out of surface, the owner can mantle onto the ledge before the character lets go.
+	bool HasReachedClimbLedge() const
+	{
+		return bReachedClimbLedge;
+	}
+
+	// Plane of the climbed surface, false if there is none.
+	bool GetClimbSurface(FVector& OutPoint, FVector& OutNormal) const;
+
+	// Directions along the climbed surface, used to map the movement input onto it.
+	FVector GetClimbUpVector() const;
+	FVector GetClimbRightVector() const;
+
+	virtual float GetMaxSpeed() const override;
+	virtual float GetMaxBrakingDeceleration() const override;
+
+protected:
+	virtual void OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode) override;
+	virtual void OnMovementUpdated(float DeltaSeconds, const FVector& OldLocation, const FVector& OldVelocity) override;
+	virtual void PhysCustom(float DeltaTime, int32 Iterations) override;
+	virtual void HandleImpact(const FHitResult& Hit, float TimeSlice = 0.f, const FVector& MoveDelta = FVector::ZeroVector) override;
+
+	// Start climbing the surface in front of the character if there is a climbable one within reach.
+	bool TryStartClimbing();
+
+	void PhysClimbing(float DeltaTime, int32 Iterations);
+
+	// Reuse the cached surface while the capsule stays close to where it was probed and the surface does not move,
+	// otherwise trace for it again. Most climbing frames do not trace at all.
+	bool UpdateClimbSurface(const FVector& ProbeDirection);
+
+	bool TraceClimbSurface(const FVector& Direction, FHitResult& OutHit) const;
+	bool IsClimbableSurface(const FHitResult& Hit) const;
+	void SetClimbSurface(const FHitResult& Hit);
+
+protected:
+	UPROPERTY(EditDefaultsOnly, Category = "Character Movement: Climbing")
+	float MaxClimbSpeed = 120.f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Character Movement: Climbing")
+	float BrakingDecelerationClimbing = 1000.f;
+
+	// How far past the capsule radius a surface can be to start climbing it.
+	UPROPERTY(EditDefaultsOnly, Category = "Character Movement: Climbing")
+	float ClimbReachDistance = 30.f;
+
+	// Gap kept between the capsule and the climbed surface.
+	UPROPERTY(EditDefaultsOnly, Category = "Character Movement: Climbing")
+	float ClimbSurfaceGap = 2.f;
+
+	// Surfaces whose normal points further up or down than this are floors or ceilings, not walls.
+	UPROPERTY(EditDefaultsOnly, Category = "Character Movement: Climbing")
+	float ClimbMaxSurfaceNormalZ = 0.5f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Character Movement: Climbing")
+	float ClimbRotationSpeed = 10.f;
+
+	// The cached surface is reused until the capsule moves this far from where it was probed.
+	UPROPERTY(EditDefaultsOnly, Category = "Character Movement: Climbing")
+	float ClimbProbeReuseDistance = 20.f;
+
+	// ...or a move hits a surface whose normal differs from it by more than this, in degrees.
+	UPROPERTY(EditDefaultsOnly, Category = "Character Movement: Climbing")
+	float ClimbProbeMaxNormalAngle = 10.f;
+
+	// How long the character holds on at the top of a surface waiting for a mantle before it lets go.
+	UPROPERTY(EditDefaultsOnly, Category = "Character Movement: Climbing")
+	float ClimbLedgeGraceTime = 0.2f;
+
+	// Start climbing when falling into a climbable surface while moving towards it.
+	UPROPERTY(EditDefaultsOnly, Category = "Character Movement: Climbing")
+	bool bClimbWhenFallingIntoSurface = true;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Character Movement: Climbing")
+	TEnumAsByte<ECollisionChannel> ClimbTraceChannel = ECC_Visibility;
+
+	struct FClimbSurface
+	{
+		FVector ImpactPoint = FVector::ZeroVector;
+		FVector Normal = FVector::ZeroVector;
+		// Capsule location the surface was probed from.
+		FVector ProbeLocation = FVector::ZeroVector;
+		TWeakObjectPtr<const UPrimitiveComponent> Component;
+		bool bValid = false;
+	};
+
+	FClimbSurface ClimbSurface;
+	bool bReachedClimbLedge = false;
+	float ClimbLedgeHeldTime = 0.f;
+
+	// Falling impacts only record the surface, climbing starts once the move has finished.
+	bool bPendingClimbStart = false;
+	FHitResult PendingClimbHit;
+#pragma endregion
+
+protected:
+	virtual void PerformMovement(float DeltaTime) override;
+	virtual void UpdateFromCompressedFlags(uint8 Flags) override;
+	virtual void UpdateCharacterStateBeforeMovement(float DeltaSeconds) override;
+	virtual void UpdateCharacterStateAfterMovement(float DeltaSeconds) override;
+	virtual void PhysicsRotation(float DeltaTime) override;
+	virtual void SimulatedTick(float DeltaSeconds) override;
+
+	void UpdateTimedEffects(float DeltaTime);
+
+	// End the mantle action once its root motion source has finished or is gone.
+	void UpdateMantleEnd();
+	const FRootMotionSource* FindMantleSource() const;
+
+	static bool IsMantleAction(ELSMovementAction Action)
+	{
+		return Action == ELSMovementAction::LowMantle || Action == ELSMovementAction::HighMantle;
+	}
+
+	// Stance changes in the callback would otherwise happen in the middle of the move.
+	void BroadcastEndedAction();
+
+protected:
+	float RestoreBrakingFrictionFactor = 0.f;
+	float LandingFrictionTimeRemaining = 0.f;
+	bool bLandingFrictionActive = false;
+
+	ELSMovementAction TimedAction = ELSMovementAction::None;
+	float TimedActionElapsed = 0.f;
+	float TimedActionDuration = 0.f;
+	ELSMovementAction PendingEndedAction = ELSMovementAction::None;
+
+	// Consumed by the move they are sent with.
+	bool bWantsToMantle = false;
+	bool bWantsToClimb = false;
 };
@@ -0,0 +1,404 @@
+// Copyright BanMing
+
+#include "Components/LSInputRecorderComponent.h"
+
+#include "Characters/LSCharacterBase.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "LocomotionSystem.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+
+ULSInputRecorderComponent::ULSInputRecorderComponent()
+{
+	// Only ticks while recording or replaying, see AddTickPrerequisites for the order.
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	PrimaryComponentTick.TickGroup = TG_PrePhysics;
+}
+
+void ULSInputRecorderComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// The character's locomotion update reads the recorded or replayed input.
+	if (AActor* Owner = GetOwner())
+	{
+		Owner->PrimaryActorTick.AddPrerequisite(this, PrimaryComponentTick);
+	}
+}
+
+void ULSInputRecorderComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (Mode == ELSInputRecorderMode::Replaying)
+	{
+		StopReplay();
+	}
+	Mode = ELSInputRecorderMode::Idle;
+	RemoveTickPrerequisites();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ULSInputRecorderComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	ALSCharacterBase* Character = GetCharacter();
+	if (Character == nullptr)
+	{
+		return;
+	}
+
+	if (Mode == ELSInputRecorderMode::Recording)
+	{
+		TickRecording(*Character, DeltaTime);
+	}
+	else if (Mode == ELSInputRecorderMode::Replaying)
+	{
+		TickReplay(*Character);
+	}
+}
+
+void ULSInputRecorderComponent::StartRecording()
+{
+	ALSCharacterBase* Character = GetCharacter();
+	if (Character == nullptr || Mode == ELSInputRecorderMode::Replaying)
+	{
+		return;
+	}
+
+	FLSStateFrame StartState;
+	Character->GetRecordedState(StartState);
+	Recording.Reset(MaxRecordedFrames, StartState);
+
+	Mode = ELSInputRecorderMode::Recording;
+	AddTickPrerequisites();
+	SetComponentTickEnabled(true);
+}
+
+bool ULSInputRecorderComponent::StopRecording(const FString& FileName)
+{
+	if (Mode != ELSInputRecorderMode::Recording)
+	{
+		return false;
+	}
+
+	// The state of the last frame is only known once it has been simulated.
+	ALSCharacterBase* Character = GetCharacter();
+	if (Character && Recording.Num() > 0)
+	{
+		Character->GetRecordedState(Recording[Recording.Num() - 1].State);
+	}
+
+	Mode = ELSInputRecorderMode::Idle;
+	RemoveTickPrerequisites();
+	SetComponentTickEnabled(false);
+
+	if (FileName.IsEmpty())
+	{
+		return true;
+	}
+
+	const FString Path = GetRecordingPath(FileName);
+	if (!Recording.SaveToFile(Path))
+	{
+		UE_LOG(LogLocomotion, Error, TEXT("Failed to save the input recording to '%s'."), *Path);
+		return false;
+	}
+
+	UE_LOG(LogLocomotion, Log, TEXT("Saved %d recorded frames to '%s'."), Recording.Num(), *Path);
+	return true;
+}
+
+bool ULSInputRecorderComponent::StartReplay(const FString& FileName, const FString& GoldenFileName)
+{
+	ALSCharacterBase* Character = GetCharacter();
+	if (Character == nullptr || Mode != ELSInputRecorderMode::Idle)
+	{
+		return false;
+	}
+
+	const FString Path = GetRecordingPath(FileName);
+	if (!Recording.LoadFromFile(Path) || Recording.Num() == 0)
+	{
+		UE_LOG(LogLocomotion, Error, TEXT("Failed to load the input recording '%s'."), *Path);
+		return false;
+	}
+
+	GoldenFileToWrite.Reset();
+	Golden = Recording;
+	if (!GoldenFileName.IsEmpty())
+	{
+		const FString GoldenPath = GetRecordingPath(GoldenFileName);
+		if (!FPaths::FileExists(GoldenPath))
+		{
+			UE_LOG(LogLocomotion, Log, TEXT("Golden file '%s' does not exist, it is written from this replay."), *GoldenPath);
+			GoldenFileToWrite = GoldenPath;
+		}
+		else if (!Golden.LoadFromFile(GoldenPath))
+		{
+			UE_LOG(LogLocomotion, Error, TEXT("Failed to load the golden file '%s'."), *GoldenPath);
+			return false;
+		}
+	}
+
+	Character->ApplyRecordedState(Recording.GetStartState());
+	SetReplayInputEnabled(false);
+
+	if (bReplayWithRecordedDeltaTime)
+	{
+		bRestoreFixedTimeStep = true;
+		bRestoreUseFixedTimeStep = FApp::UseFixedTimeStep();
+		RestoreFixedDeltaTime = FApp::GetFixedDeltaTime();
+		FApp::SetUseFixedTimeStep(true);
+		FApp::SetFixedDeltaTime(Recording[0].Input.DeltaTime);
+	}
+
+	ReplayedStates.Reset(Recording.Num());
+	ReplayFrame = 0;
+	Report = FLSReplayReport();
+	LastReplayFrameTime = 0.0;
+
+	Mode = ELSInputRecorderMode::Replaying;
+	AddTickPrerequisites();
+	SetComponentTickEnabled(true);
+	return true;
+}
+
+void ULSInputRecorderComponent::StopReplay()
+{
+	if (Mode != ELSInputRecorderMode::Replaying)
+	{
+		return;
+	}
+
+	if (bRestoreFixedTimeStep)
+	{
+		bRestoreFixedTimeStep = false;
+		FApp::SetUseFixedTimeStep(bRestoreUseFixedTimeStep);
+		FApp::SetFixedDeltaTime(RestoreFixedDeltaTime);
+	}
+
+	SetReplayInputEnabled(true);
+	Mode = ELSInputRecorderMode::Idle;
+	RemoveTickPrerequisites();
+	SetComponentTickEnabled(false);
+}
+
+FString ULSInputRecorderComponent::GetRecordingPath(const FString& Name)
+{
+	FString Path = FPaths::IsRelative(Name) ? FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("LocomotionRecordings"), Name) : Name;
+	if (FPaths::GetExtension(Path).IsEmpty())
+	{
+		Path += TEXT(".lsrec");
+	}
+	return Path;
+}
+
+void ULSInputRecorderComponent::TickRecording(ALSCharacterBase& Character, float DeltaTime)
+{
+	// Last frame has been simulated by now.
+	if (Recording.Num() > 0)
+	{
+		Character.GetRecordedState(Recording[Recording.Num() - 1].State);
+	}
+
+	FLSRecordedFrame& Frame = Recording.Add();
+	Character.GetRecordedInput(Frame.Input);
+	Frame.Input.DeltaTime = DeltaTime;
+}
+
+void ULSInputRecorderComponent::TickReplay(ALSCharacterBase& Character)
+{
+	const double Now = FPlatformTime::Seconds();
+
+	if (ReplayFrame > 0)
+	{
+		const int32 Frame = ReplayFrame - 1;
+		FLSStateFrame& State = ReplayedStates.AddDefaulted_GetRef();
+		Character.GetRecordedState(State);
+		if (Frame < Golden.Num())
+		{
+			Report.CompareFrame(Frame, State, Golden[Frame].State, ReplayYawTolerance, ReplaySpeedTolerance, ReplayLocationTolerance);
+		}
+
+		const double FrameSeconds = Now - LastReplayFrameTime;
+		Report.TotalSeconds += FrameSeconds;
+		Report.MaxFrameSeconds = FMath::Max(Report.MaxFrameSeconds, FrameSeconds);
+	}
+
+	if (ReplayFrame >= Recording.Num())
+	{
+		FinishReplay();
+		return;
+	}
+
+	Character.ApplyRecordedInput(Recording[ReplayFrame].Input);
+
+	// Takes effect from the next engine frame on, which replays the next recorded frame.
+	if (bReplayWithRecordedDeltaTime && ReplayFrame + 1 < Recording.Num())
+	{
+		FApp::SetFixedDeltaTime(Recording[ReplayFrame + 1].Input.DeltaTime);
+	}
+
+	++ReplayFrame;
+	LastReplayFrameTime = Now;
+}
+
+void ULSInputRecorderComponent::FinishReplay()
+{
+	StopReplay();
+
+	if (Golden.Num() != Recording.Num())
+	{
+		UE_LOG(LogLocomotion, Warning, TEXT("Golden trajectory has %d frames, the recording %d."), Golden.Num(), Recording.Num());
+	}
+
+	if (!GoldenFileToWrite.IsEmpty())
+	{
+		for (int32 Index = 0; Index < ReplayedStates.Num() && Index < Recording.Num(); ++Index)
+		{
+			Recording[Index].State = ReplayedStates[Index];
+		}
+
+		if (Recording.SaveToFile(GoldenFileToWrite))
+		{
+			UE_LOG(LogLocomotion, Log, TEXT("Wrote golden file '%s'."), *GoldenFileToWrite);
+		}
+		else
+		{
+			UE_LOG(LogLocomotion, Error, TEXT("Failed to write golden file '%s'."), *GoldenFileToWrite);
+		}
+	}
+
+	UE_LOG(LogLocomotion, Display, TEXT("Locomotion replay %s"), *Report.ToString());
+	OnReplayFinished.Broadcast(Report);
+
+	if (FParse::Param(FCommandLine::Get(), TEXT("LSReplayExit")))
+	{
+		FPlatformMisc::RequestExitWithStatus(false, Report.IsPassed() ? 0 : 1);
+	}
+}
+
+void ULSInputRecorderComponent::SetReplayInputEnabled(bool bEnabled)
+{
+	// Live input would add to the replayed one.
+	ALSCharacterBase* Character = GetCharacter();
+	APlayerController* PlayerController = Character ? Cast<APlayerController>(Character->GetController()) : nullptr;
+	if (PlayerController == nullptr)
+	{
+		return;
+	}
+
+	if (bEnabled)
+	{
+		Character->EnableInput(PlayerController);
+	}
+	else
+	{
+		Character->DisableInput(PlayerController);
+	}
+}
+
+void ULSInputRecorderComponent::AddTickPrerequisites()
+{
+	RemoveTickPrerequisites();
+
+	ALSCharacterBase* Character = GetCharacter();
+	if (Character == nullptr)
+	{
+		return;
+	}
+
+	// After the controller has processed this frame's input and turned the control rotation...
+	if (AController* Controller = Character->GetController())
+	{
+		PrimaryComponentTick.AddPrerequisite(Controller, Controller->PrimaryActorTick);
+		PrerequisiteController = Controller;
+	}
+
+	// ...and before the movement component consumes the input in its move.
+	if (UCharacterMovementComponent* MovementComp = Character->GetCharacterMovement())
+	{
+		MovementComp->PrimaryComponentTick.AddPrerequisite(this, PrimaryComponentTick);
+	}
+}
+
+void ULSInputRecorderComponent::RemoveTickPrerequisites()
+{
+	if (AController* Controller = PrerequisiteController.Get())
+	{
+		PrimaryComponentTick.RemovePrerequisite(Controller, Controller->PrimaryActorTick);
+	}
+	PrerequisiteController.Reset();
+
+	const ALSCharacterBase* Character = GetCharacter();
+	if (UCharacterMovementComponent* MovementComp = Character ? Character->GetCharacterMovement() : nullptr)
+	{
+		MovementComp->PrimaryComponentTick.RemovePrerequisite(this, PrimaryComponentTick);
+	}
+}
+
+ALSCharacterBase* ULSInputRecorderComponent::GetCharacter() const
+{
+	return Cast<ALSCharacterBase>(GetOwner());
+}
+
+static ULSInputRecorderComponent* FindLocalRecorder(UWorld* World)
+{
+	const APlayerController* PlayerController = World ? World->GetFirstPlayerController() : nullptr;
+	APawn* Pawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+	if (!Cast<ALSCharacterBase>(Pawn))
+	{
+		UE_LOG(LogLocomotion, Warning, TEXT("The local player does not control an LS character."));
+		return nullptr;
+	}
+
+	ULSInputRecorderComponent* Recorder = Pawn->FindComponentByClass<ULSInputRecorderComponent>();
+	if (Recorder == nullptr)
+	{
+		Recorder = NewObject<ULSInputRecorderComponent>(Pawn);
+		Recorder->RegisterComponent();
+	}
+	return Recorder;
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GInputRecordCommand(TEXT("LS.Input.Record"), TEXT("Start recording the locomotion input of the local player's character."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda(
+		[](const TArray<FString>& Args, UWorld* World)
+		{
+			if (ULSInputRecorderComponent* Recorder = FindLocalRecorder(World))
+			{
+				Recorder->StartRecording();
+			}
+		}));
+
+static FAutoConsoleCommandWithWorldAndArgs GInputSaveCommand(TEXT("LS.Input.Save"), TEXT("LS.Input.Save <Name>: stop recording and save the recording."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda(
+		[](const TArray<FString>& Args, UWorld* World)
+		{
+			if (ULSInputRecorderComponent* Recorder = FindLocalRecorder(World))
+			{
+				Recorder->StopRecording(Args.Num() > 0 ? Args[0] : TEXT("Recording"));
+			}
+		}));
+
+static FAutoConsoleCommandWithWorldAndArgs GInputReplayCommand(TEXT("LS.Input.Replay"), TEXT("LS.Input.Replay <Name> [Golden]: replay a recording on the local player's character and compare it with the golden trajectory."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda(
+		[](const TArray<FString>& Args, UWorld* World)
+		{
+			if (Args.Num() == 0)
+			{
+				return;
+			}
+
+			if (ULSInputRecorderComponent* Recorder = FindLocalRecorder(World))
+			{
+				Recorder->StartReplay(Args[0], Args.Num() > 1 ? Args[1] : FString());
+			}
+		}));
@@ -0,0 +1,109 @@
+// Copyright BanMing
+
+#pragma once
+
+#include "Components/ActorComponent.h"
+#include "CoreMinimal.h"
+#include "Data/LocomotionRecording.h"
+
+#include "LSInputRecorderComponent.generated.h"
+
+class AController;
+class ALSCharacterBase;
+
+UENUM()
+enum class ELSInputRecorderMode : uint8
+{
+	Idle,
+	Recording,
+	Replaying
+};
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnLSReplayFinished, const FLSReplayReport&);
+
+/**
+ * Records the locomotion input of its LS character every frame into a ring buffer, and feeds recordings back into it.
+ * Replays step the engine with the recorded frame times and compare the gait, rotation, speed and location of every frame
+ * with a golden trajectory, which makes them usable both as regression tests and as repeatable profiling workloads.
+ * Driven by the LS.Input.* console commands, -LSReplayExit quits with the result once a replay finishes for headless runs.
+ */
+UCLASS(ClassGroup = (Locomotion), meta = (BlueprintSpawnableComponent))
+class LOCOMOTIONSYSTEM_API ULSInputRecorderComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	ULSInputRecorderComponent();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	void StartRecording();
+
+	// Stop recording and write the recording to the file, unless the file name is empty.
+	bool StopRecording(const FString& FileName);
+
+	// Replay a recording, comparing it with the trajectory of the golden file.
+	// Without a golden file the recording's own trajectory is used, and a golden file that does not exist yet is written from the replay.
+	bool StartReplay(const FString& FileName, const FString& GoldenFileName);
+	void StopReplay();
+
+	ELSInputRecorderMode GetMode() const
+	{
+		return Mode;
+	}
+
+	// Recordings live in Saved/LocomotionRecordings unless an absolute path is given.
+	static FString GetRecordingPath(const FString& Name);
+
+	FOnLSReplayFinished OnReplayFinished;
+
+protected:
+	void TickRecording(ALSCharacterBase& Character, float DeltaTime);
+	void TickReplay(ALSCharacterBase& Character);
+	void FinishReplay();
+
+	void SetReplayInputEnabled(bool bEnabled);
+
+	// Tick between the controller, which adds the frame's input, and the movement component, which consumes it.
+	void AddTickPrerequisites();
+	void RemoveTickPrerequisites();
+
+	ALSCharacterBase* GetCharacter() const;
+
+protected:
+	// 5 minutes at 60 fps, older frames are dropped.
+	UPROPERTY(EditDefaultsOnly, Category = "Input Recording", meta = (ClampMin = "1"))
+	int32 MaxRecordedFrames = 18000;
+
+	// Step the engine with the recorded frame times during replays, so the result does not depend on the frame rate of the machine.
+	UPROPERTY(EditDefaultsOnly, Category = "Input Recording")
+	bool bReplayWithRecordedDeltaTime = true;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Input Recording")
+	float ReplayYawTolerance = 1.f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Input Recording")
+	float ReplaySpeedTolerance = 5.f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Input Recording")
+	float ReplayLocationTolerance = 10.f;
+
+private:
+	ELSInputRecorderMode Mode = ELSInputRecorderMode::Idle;
+	FLSLocomotionRecording Recording;
+	TWeakObjectPtr<AController> PrerequisiteController;
+
+	// Replay state
+	FLSLocomotionRecording Golden;
+	FString GoldenFileToWrite;
+	TArray<FLSStateFrame> ReplayedStates;
+	int32 ReplayFrame = 0;
+	FLSReplayReport Report;
+	double LastReplayFrameTime = 0.0;
+
+	bool bRestoreFixedTimeStep = false;
+	bool bRestoreUseFixedTimeStep = false;
+	double RestoreFixedDeltaTime = 0.0;
+};
@@ -0,0 +1,136 @@
+// Copyright BanMing
+
+#include "Components/LSRootMotionSource_Mantle.h"
+
+#include "Components/PrimitiveComponent.h"
+#include "Curves/CurveVector.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/CharacterMovementComponent.h"
+
+FTransform FLSMantleParams::GetTargetTransform() const
+{
+	return LedgeComponent ? LedgeTransform * LedgeComponent->GetComponentTransform() : LedgeTransform;
+}
+
+void FLSMantleParams::Evaluate(float Time, FVector& OutLocation, FQuat& OutRotation) const
+{
+	const FTransform Target = GetTargetTransform();
+	const FVector TargetLocation = Target.GetLocation();
+	const FQuat TargetRotation = Target.GetRotation();
+	const FVector StartLocation = TargetLocation + ActualStartOffset;
+	const FQuat StartRotation = (Target.Rotator() + ActualStartRotationOffset).Quaternion();
+
+	// X: position alpha, Y: horizontal correction alpha, Z: vertical correction alpha.
+	const FVector Alphas = PositionCorrectionCurve ? PositionCorrectionCurve->GetVectorValue(StartingPosition + Time * PlayRate) : FVector::OneVector;
+
+	// Blend into the animated horizontal and vertical offsets independently, so the capsule lines up with where the animation starts.
+	const FVector HorizontalAnimated = TargetLocation + FVector(AnimatedStartOffset.X, AnimatedStartOffset.Y, ActualStartOffset.Z);
+	const FVector VerticalAnimated = TargetLocation + FVector(ActualStartOffset.X, ActualStartOffset.Y, AnimatedStartOffset.Z);
+	const FVector Horizontal = FMath::Lerp(StartLocation, HorizontalAnimated, Alphas.Y);
+	const FVector Vertical = FMath::Lerp(StartLocation, VerticalAnimated, Alphas.Z);
+	const FQuat CorrectedRotation = FQuat::Slerp(StartRotation, TargetRotation, Alphas.Y);
+
+	// Blend from the corrected path into the final target.
+	const FVector ResultLocation = FMath::Lerp(FVector(Horizontal.X, Horizontal.Y, Vertical.Z), TargetLocation, Alphas.X);
+	const FQuat ResultRotation = FQuat::Slerp(CorrectedRotation, TargetRotation, Alphas.X);
+
+	const float BlendIn = BlendInTime > 0.f ? FMath::Clamp(Time / BlendInTime, 0.f, 1.f) : 1.f;
+	OutLocation = FMath::Lerp(StartLocation, ResultLocation, BlendIn);
+	OutRotation = FQuat::Slerp(StartRotation, ResultRotation, BlendIn);
+}
+
+FLSRootMotionSource_Mantle::FLSRootMotionSource_Mantle()
+{
+	// The mantle path is absolute, nothing else should move the capsule meanwhile.
+	AccumulateMode = ERootMotionAccumulateMode::Override;
+	FinishVelocityParams.Mode = ERootMotionFinishVelocityMode::SetVelocity;
+	FinishVelocityParams.SetVelocity = FVector::ZeroVector;
+}
+
+FRootMotionSource* FLSRootMotionSource_Mantle::Clone() const
+{
+	return new FLSRootMotionSource_Mantle(*this);
+}
+
+bool FLSRootMotionSource_Mantle::Matches(const FRootMotionSource* Other) const
+{
+	if (!FRootMotionSource::Matches(Other))
+	{
+		return false;
+	}
+
+	// FRootMotionSource::Matches already checked the script struct.
+	const FLSRootMotionSource_Mantle* OtherCast = static_cast<const FLSRootMotionSource_Mantle*>(Other);
+	return MantleParams.LedgeComponent == OtherCast->MantleParams.LedgeComponent && MantleParams.PositionCorrectionCurve == OtherCast->MantleParams.PositionCorrectionCurve &&
+		   MantleParams.LedgeTransform.Equals(OtherCast->MantleParams.LedgeTransform) && FMath::IsNearlyEqual(MantleParams.PlayRate, OtherCast->MantleParams.PlayRate) &&
+		   FMath::IsNearlyEqual(MantleParams.StartingPosition, OtherCast->MantleParams.StartingPosition);
+}
+
+bool FLSRootMotionSource_Mantle::MatchesAndHasSameState(const FRootMotionSource* Other) const
+{
+	// The only state is the time, compared by the base class.
+	return FRootMotionSource::MatchesAndHasSameState(Other);
+}
+
+bool FLSRootMotionSource_Mantle::UpdateStateFrom(const FRootMotionSource* SourceToTakeStateFrom, bool bMarkForSimulatedCatchup)
+{
+	return FRootMotionSource::UpdateStateFrom(SourceToTakeStateFrom, bMarkForSimulatedCatchup);
+}
+
+void FLSRootMotionSource_Mantle::PrepareRootMotion(float SimulationTime, float MovementTickTime, const ACharacter& Character, const UCharacterMovementComponent& MoveComponent)
+{
+	RootMotionParams.Clear();
+
+	if (Duration > UE_SMALL_NUMBER && MovementTickTime > UE_SMALL_NUMBER)
+	{
+		// Velocity that takes the capsule from where it is to where the path is at the end of this tick.
+		const float NewTime = FMath::Min(GetTime() + SimulationTime, Duration);
+		FVector TargetLocation;
+		FQuat TargetRotation;
+		MantleParams.Evaluate(NewTime, TargetLocation, TargetRotation);
+
+		const FVector CurrentLocation = Character.GetActorLocation();
+		RootMotionParams.Set(FTransform((TargetLocation - CurrentLocation) / MovementTickTime));
+	}
+
+	SetTime(GetTime() + SimulationTime);
+}
+
+bool FLSRootMotionSource_Mantle::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	if (!FRootMotionSource::NetSerialize(Ar, Map, bOutSuccess))
+	{
+		return false;
+	}
+
+	Ar << MantleParams.LedgeComponent;
+	Ar << MantleParams.LedgeTransform;
+	Ar << MantleParams.ActualStartOffset;
+	Ar << MantleParams.ActualStartRotationOffset;
+	Ar << MantleParams.AnimatedStartOffset;
+	Ar << MantleParams.PositionCorrectionCurve;
+	Ar << MantleParams.StartingPosition;
+	Ar << MantleParams.PlayRate;
+	Ar << MantleParams.BlendInTime;
+
+	bOutSuccess = true;
+	return true;
+}
+
+UScriptStruct* FLSRootMotionSource_Mantle::GetScriptStruct() const
+{
+	return FLSRootMotionSource_Mantle::StaticStruct();
+}
+
+FString FLSRootMotionSource_Mantle::ToSimpleString() const
+{
+	return FString::Printf(TEXT("[ID:%u]FLSRootMotionSource_Mantle %s"), LocalID, *InstanceName.GetPlainNameString());
+}
+
+void FLSRootMotionSource_Mantle::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	Collector.AddReferencedObject(MantleParams.LedgeComponent);
+	Collector.AddReferencedObject(MantleParams.PositionCorrectionCurve);
+
+	FRootMotionSource::AddReferencedObjects(Collector);
+}
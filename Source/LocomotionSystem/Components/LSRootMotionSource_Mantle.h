@@ -0,0 +1,95 @@
+// Copyright BanMing
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/RootMotionSource.h"
+
+#include "LSRootMotionSource_Mantle.generated.h"
+
+class UCurveVector;
+class UPrimitiveComponent;
+
+USTRUCT()
+struct LOCOMOTIONSYSTEM_API FLSMantleParams
+{
+	GENERATED_BODY()
+
+	// The ledge the mantle ends on, followed while it moves. Null for a ledge in world space.
+	UPROPERTY()
+	TObjectPtr<UPrimitiveComponent> LedgeComponent;
+
+	// Target capsule transform relative to the Ledge Component.
+	UPROPERTY()
+	FTransform LedgeTransform = FTransform::Identity;
+
+	// Where the capsule actually started, relative to the target.
+	UPROPERTY()
+	FVector ActualStartOffset = FVector::ZeroVector;
+
+	UPROPERTY()
+	FRotator ActualStartRotationOffset = FRotator::ZeroRotator;
+
+	// Where the animation expects the capsule to start, relative to the target.
+	UPROPERTY()
+	FVector AnimatedStartOffset = FVector::ZeroVector;
+
+	UPROPERTY()
+	TObjectPtr<UCurveVector> PositionCorrectionCurve;
+
+	UPROPERTY()
+	float StartingPosition = 0.f;
+
+	UPROPERTY()
+	float PlayRate = 1.f;
+
+	// Blend from the actual start into the corrected path over this long, avoids pops on ledges lower than the animated one.
+	UPROPERTY()
+	float BlendInTime = 0.2f;
+
+	// Mantle target in world space, following the ledge.
+	FTransform GetTargetTransform() const;
+
+	// Capsule location and rotation Time seconds into the mantle.
+	void Evaluate(float Time, FVector& OutLocation, FQuat& OutRotation) const;
+};
+
+/**
+ * Moves the capsule along the corrected mantle path.
+ * As a root motion source the mantle is predicted, replayed and replicated with regular movement,
+ * instead of teleporting the actor from a timeline every frame.
+ */
+USTRUCT()
+struct LOCOMOTIONSYSTEM_API FLSRootMotionSource_Mantle : public FRootMotionSource
+{
+	GENERATED_USTRUCT_BODY()
+
+	FLSRootMotionSource_Mantle();
+
+	virtual ~FLSRootMotionSource_Mantle() override
+	{
+	}
+
+	UPROPERTY()
+	FLSMantleParams MantleParams;
+
+	virtual FRootMotionSource* Clone() const override;
+	virtual bool Matches(const FRootMotionSource* Other) const override;
+	virtual bool MatchesAndHasSameState(const FRootMotionSource* Other) const override;
+	virtual bool UpdateStateFrom(const FRootMotionSource* SourceToTakeStateFrom, bool bMarkForSimulatedCatchup = false) override;
+	virtual void PrepareRootMotion(float SimulationTime, float MovementTickTime, const ACharacter& Character, const UCharacterMovementComponent& MoveComponent) override;
+	virtual bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess) override;
+	virtual UScriptStruct* GetScriptStruct() const override;
+	virtual FString ToSimpleString() const override;
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+};
+
+template <>
+struct TStructOpsTypeTraits<FLSRootMotionSource_Mantle> : public TStructOpsTypeTraitsBase2<FLSRootMotionSource_Mantle>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithCopy = true
+	};
+};
@@ -0,0 +1,29 @@
+// Copyright BanMing
+
+#include "Data/ActionMontageSet.h"
+
+#include "Animation/AnimMontage.h"
+
+TSoftObjectPtr<UAnimMontage> ULSActionMontageSet::FindMontage(ELSMovementAction MovementAction, ELSOverlayState OverlayState) const
+{
+	TSoftObjectPtr<UAnimMontage> Fallback;
+	for (const FLSActionMontageEntry& Entry : Montages)
+	{
+		if (Entry.MovementAction != MovementAction)
+		{
+			continue;
+		}
+
+		if (Entry.OverlayState == OverlayState)
+		{
+			return Entry.Montage;
+		}
+
+		if (Entry.OverlayState == ELSOverlayState::Default)
+		{
+			Fallback = Entry.Montage;
+		}
+	}
+
+	return Fallback;
+}
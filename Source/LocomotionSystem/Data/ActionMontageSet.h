@@ -0,0 +1,44 @@
+// Copyright BanMing
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/LocomotionTypes.h"
+#include "Engine/DataAsset.h"
+
+#include "ActionMontageSet.generated.h"
+
+class UAnimMontage;
+
+USTRUCT(BlueprintType)
+struct FLSActionMontageEntry
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	ELSMovementAction MovementAction = ELSMovementAction::None;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	ELSOverlayState OverlayState = ELSOverlayState::Default;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	TSoftObjectPtr<UAnimMontage> Montage;
+};
+
+/**
+ * Action montages (roll, breakfall, get up and mantles) keyed by Movement Action and Overlay State.
+ * Montages are soft references, characters preload the ones their current state can trigger.
+ */
+UCLASS(BlueprintType)
+class LOCOMOTIONSYSTEM_API ULSActionMontageSet : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	// Find the montage for the action in the overlay, falling back to the Default overlay.
+	TSoftObjectPtr<UAnimMontage> FindMontage(ELSMovementAction MovementAction, ELSOverlayState OverlayState) const;
+
+protected:
+	UPROPERTY(EditDefaultsOnly, Category = "Actions")
+	TArray<FLSActionMontageEntry> Montages;
+};
@@ -0,0 +1,41 @@
+// Copyright BanMing
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "AnimationSharingStates.generated.h"
+
+/**
+ * Shared pose states for distant LS characters, one per (overlay style, stance, gait).
+ * Only the overlays that change the whole body get their own set, the rest use Default.
+ * The order of the grounded states is relied on by ULSAnimationSharingStateProcessor.
+ */
+UENUM(BlueprintType)
+enum class ELSAnimationSharingState : uint8
+{
+	Default_StandingIdle,
+	Default_StandingWalk,
+	Default_StandingRun,
+	Default_StandingSprint,
+	Default_CrouchingIdle,
+	Default_CrouchingWalk,
+
+	Masculine_StandingIdle,
+	Masculine_StandingWalk,
+	Masculine_StandingRun,
+	Masculine_StandingSprint,
+	Masculine_CrouchingIdle,
+	Masculine_CrouchingWalk,
+
+	Feminine_StandingIdle,
+	Feminine_StandingWalk,
+	Feminine_StandingRun,
+	Feminine_StandingSprint,
+	Feminine_CrouchingIdle,
+	Feminine_CrouchingWalk,
+
+	InAir,
+	Mantling,
+	Climbing
+};
@@ -0,0 +1,94 @@
+// Copyright BanMing
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+
+#include "ClimbingIKSettings.generated.h"
+
+UENUM(BlueprintType)
+enum class ELSClimbingLimb : uint8
+{
+	HandL,
+	HandR,
+	FootL,
+	FootR,
+	MAX UMETA(Hidden)
+};
+
+USTRUCT(BlueprintType)
+struct FLSClimbingLimbTarget
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Climbing IK")
+	FVector Location = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Climbing IK")
+	FVector Normal = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Climbing IK")
+	float Alpha = 0.f;
+};
+
+struct FLSClimbingLimbTargets
+{
+	FLSClimbingLimbTarget Limbs[static_cast<int32>(ELSClimbingLimb::MAX)];
+};
+
+USTRUCT(BlueprintType)
+struct FLSClimbingIKSettings
+{
+	GENERATED_BODY()
+
+	// Where each limb reaches for the surface relative to the capsule center, X along the surface's right and Y along its up.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	FVector2D HandLOffset = FVector2D(-25.f, 60.f);
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	FVector2D HandROffset = FVector2D(25.f, 60.f);
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	FVector2D FootLOffset = FVector2D(-15.f, -75.f);
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	FVector2D FootROffset = FVector2D(15.f, -75.f);
+
+	// Probes start this far out from the surface and reach this far through it.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	float ProbeStartDistance = 30.f;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	float ProbeDepth = 80.f;
+
+	// Probes are placed where the capsule will be this far ahead, which hides the frame of latency of the async traces.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	float PredictionTime = 0.15f;
+
+	// Remote climbers look for the climbed surface themselves, again once they moved this far from where they last did.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	float ProxySurfaceReuseDistance = 20.f;
+
+	// Above this mesh LOD the limbs are projected onto the climbed surface plane instead of traced.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	int32 MaxTraceLOD = 1;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	TEnumAsByte<ECollisionChannel> TraceChannel = ECC_Visibility;
+
+	const FVector2D& GetLimbOffset(ELSClimbingLimb Limb) const
+	{
+		switch (Limb)
+		{
+			case ELSClimbingLimb::HandL:
+				return HandLOffset;
+			case ELSClimbingLimb::HandR:
+				return HandROffset;
+			case ELSClimbingLimb::FootL:
+				return FootLOffset;
+			default:
+				return FootROffset;
+		}
+	}
+};
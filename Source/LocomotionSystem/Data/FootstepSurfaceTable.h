@@ -0,0 +1,54 @@
+// Copyright BanMing
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Chaos/ChaosEngineInterface.h"
+#include "Engine/DataAsset.h"
+
+#include "FootstepSurfaceTable.generated.h"
+
+class UMaterialInterface;
+class USoundBase;
+
+USTRUCT(BlueprintType)
+struct FLSFootstepSurface
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	TObjectPtr<USoundBase> Sound;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	TObjectPtr<UMaterialInterface> DecalMaterial;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	FVector DecalSize = FVector(10.f, 20.f, 10.f);
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	float DecalLifeSpan = 4.f;
+};
+
+/**
+ * Footstep sound and decal for each physical surface type.
+ */
+UCLASS(BlueprintType)
+class LOCOMOTIONSYSTEM_API ULSFootstepSurfaceTable : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	// Get the entry for the surface, falling back to the default surface.
+	const FLSFootstepSurface& GetSurface(EPhysicalSurface SurfaceType) const
+	{
+		const FLSFootstepSurface* Surface = Surfaces.Find(SurfaceType);
+		return Surface ? *Surface : DefaultSurface;
+	}
+
+protected:
+	UPROPERTY(EditDefaultsOnly, Category = "Footsteps")
+	FLSFootstepSurface DefaultSurface;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Footsteps")
+	TMap<TEnumAsByte<EPhysicalSurface>, FLSFootstepSurface> Surfaces;
+};
@@ -0,0 +1,26 @@
+// Copyright BanMing
+
+#include "Data/LocomotionEvents.h"
+
+FLSLocomotionEventQueueRef FLSLocomotionEventStream::Subscribe()
+{
+	check(IsInGameThread());
+	return Subscribers.Add_GetRef(MakeShared<FLSLocomotionEventQueue, ESPMode::ThreadSafe>());
+}
+
+void FLSLocomotionEventStream::Push(const FLSLocomotionEvent& Event)
+{
+	check(IsInGameThread());
+
+	for (int32 Index = Subscribers.Num() - 1; Index >= 0; --Index)
+	{
+		// Only referenced from here, the subscriber is gone.
+		if (Subscribers[Index].GetSharedReferenceCount() == 1)
+		{
+			Subscribers.RemoveAtSwap(Index);
+			continue;
+		}
+
+		Subscribers[Index]->Enqueue(Event, MaxQueuedEvents);
+	}
+}
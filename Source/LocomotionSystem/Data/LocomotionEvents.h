@@ -0,0 +1,91 @@
+// Copyright BanMing
+
+#pragma once
+
+#include "Containers/SpscQueue.h"
+#include "CoreMinimal.h"
+
+#include <atomic>
+
+#include "LocomotionEvents.generated.h"
+
+UENUM(BlueprintType)
+enum class ELSLocomotionEventType : uint8
+{
+	Jumped,
+	Landed,
+	MovementStateChanged,
+	GaitChanged,
+	StanceChanged,
+	ActionStarted,
+	ActionEnded
+};
+
+struct FLSLocomotionEvent
+{
+	ELSLocomotionEventType Type = ELSLocomotionEventType::Jumped;
+
+	// Enum values before and after a change, the action for ActionStarted and ActionEnded.
+	uint8 PreviousValue = 0;
+	uint8 NewValue = 0;
+
+	// Horizontal speed when jumping, falling speed when landing.
+	float Speed = 0.f;
+
+	uint64 FrameNumber = 0;
+};
+
+// Single producer, single consumer queue of events that counts them, so the producer can tell a subscriber has stopped draining.
+class FLSLocomotionEventQueue
+{
+public:
+	bool Enqueue(const FLSLocomotionEvent& Event, int32 MaxNum)
+	{
+		if (Num.load(std::memory_order_relaxed) >= MaxNum)
+		{
+			return false;
+		}
+
+		Queue.Enqueue(Event);
+		Num.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	TOptional<FLSLocomotionEvent> Dequeue()
+	{
+		TOptional<FLSLocomotionEvent> Event = Queue.Dequeue();
+		if (Event.IsSet())
+		{
+			Num.fetch_sub(1, std::memory_order_relaxed);
+		}
+		return Event;
+	}
+
+private:
+	TSpscQueue<FLSLocomotionEvent> Queue;
+	std::atomic<int32> Num{0};
+};
+
+using FLSLocomotionEventQueueRef = TSharedRef<FLSLocomotionEventQueue, ESPMode::ThreadSafe>;
+
+/**
+ * Locomotion events of one character, pushed on the game thread into one single producer, single consumer queue per subscriber.
+ * Each subscriber drains its own queue without locks from whichever thread it updates on, e.g. an anim instance from its worker thread update.
+ * A subscriber unsubscribes by releasing its queue.
+ */
+class LOCOMOTIONSYSTEM_API FLSLocomotionEventStream
+{
+public:
+	// Game thread only.
+	FLSLocomotionEventQueueRef Subscribe();
+
+	// Game thread only. Subscribers with MaxQueuedEvents not drained yet miss the event.
+	void Push(const FLSLocomotionEvent& Event);
+
+	// A subscriber this far behind has not updated for a while, e.g. an anim instance of a hidden or pooled character.
+	// Its events are stale by the time it updates again.
+	static constexpr int32 MaxQueuedEvents = 32;
+
+private:
+	TArray<FLSLocomotionEventQueueRef> Subscribers;
+};
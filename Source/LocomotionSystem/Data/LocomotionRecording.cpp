@@ -0,0 +1,185 @@
+// Copyright BanMing
+
+#include "Data/LocomotionRecording.h"
+
+#include "Misc/FileHelper.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+// "LSIR", followed by the format version.
+static constexpr uint32 GRecordingMagic = 0x5249534C;
+static constexpr uint32 GRecordingVersion = 2;
+
+void FLSInputFrame::SetMoveAxes(float Forward, float Right)
+{
+	MoveForward = static_cast<int8>(FMath::RoundToInt32(FMath::Clamp(Forward, -1.f, 1.f) * 127.f));
+	MoveRight = static_cast<int8>(FMath::RoundToInt32(FMath::Clamp(Right, -1.f, 1.f) * 127.f));
+}
+
+float FLSInputFrame::GetMoveForward() const
+{
+	return MoveForward / 127.f;
+}
+
+float FLSInputFrame::GetMoveRight() const
+{
+	return MoveRight / 127.f;
+}
+
+void FLSInputFrame::SetControlRotation(const FRotator& Rotation)
+{
+	ControlPitch = FRotator::CompressAxisToShort(Rotation.Pitch);
+	ControlYaw = FRotator::CompressAxisToShort(Rotation.Yaw);
+}
+
+FRotator FLSInputFrame::GetControlRotation() const
+{
+	return FRotator(FRotator::DecompressAxisFromShort(ControlPitch), FRotator::DecompressAxisFromShort(ControlYaw), 0.f);
+}
+
+void FLSInputFrame::SetToggles(ELSGaitType DesiredGait, ELSStanceType DesiredStance, ELSRotationMode DesiredRotationMode, bool bSprintHeld)
+{
+	Toggles = (static_cast<uint8>(DesiredGait) & 0x3) | ((static_cast<uint8>(DesiredStance) & 0x1) << 2) | ((static_cast<uint8>(DesiredRotationMode) & 0x3) << 3) | (bSprintHeld ? 1 << 5 : 0);
+}
+
+ELSGaitType FLSInputFrame::GetDesiredGait() const
+{
+	return static_cast<ELSGaitType>(Toggles & 0x3);
+}
+
+ELSStanceType FLSInputFrame::GetDesiredStance() const
+{
+	return static_cast<ELSStanceType>((Toggles >> 2) & 0x1);
+}
+
+ELSRotationMode FLSInputFrame::GetDesiredRotationMode() const
+{
+	return static_cast<ELSRotationMode>((Toggles >> 3) & 0x3);
+}
+
+bool FLSInputFrame::IsSprintHeld() const
+{
+	return (Toggles & (1 << 5)) != 0;
+}
+
+FArchive& operator<<(FArchive& Ar, FLSInputFrame& Frame)
+{
+	Ar << Frame.DeltaTime << Frame.MoveForward << Frame.MoveRight << Frame.ControlPitch << Frame.ControlYaw << Frame.Toggles;
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FLSStateFrame& Frame)
+{
+	Ar << Frame.Location << Frame.Velocity << Frame.Yaw << Frame.Gait << Frame.Stance << Frame.RotationMode << Frame.MovementState;
+	return Ar;
+}
+
+void FLSLocomotionRecording::Reset(int32 InCapacity, const FLSStateFrame& InStartState)
+{
+	Frames.SetNum(FMath::Max(InCapacity, 1));
+	Head = 0;
+	Count = 0;
+	StartState = InStartState;
+}
+
+FLSRecordedFrame& FLSLocomotionRecording::Add()
+{
+	check(Frames.Num() > 0);
+
+	if (Count < Frames.Num())
+	{
+		return Frames[(Head + Count++) % Frames.Num()];
+	}
+
+	// Full, the oldest frame is overwritten and the next one starts where it ended.
+	StartState = Frames[Head].State;
+	FLSRecordedFrame& Frame = Frames[Head];
+	Head = (Head + 1) % Frames.Num();
+	return Frame;
+}
+
+bool FLSLocomotionRecording::SaveToFile(const FString& FileName) const
+{
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+	const_cast<FLSLocomotionRecording*>(this)->Serialize(Writer);
+	return FFileHelper::SaveArrayToFile(Bytes, *FileName);
+}
+
+bool FLSLocomotionRecording::LoadFromFile(const FString& FileName)
+{
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *FileName))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(Bytes);
+	Serialize(Reader);
+	return !Reader.IsError();
+}
+
+void FLSLocomotionRecording::Serialize(FArchive& Ar)
+{
+	uint32 Magic = GRecordingMagic;
+	uint32 Version = GRecordingVersion;
+	Ar << Magic << Version;
+	if (Ar.IsLoading() && (Magic != GRecordingMagic || Version != GRecordingVersion))
+	{
+		Ar.SetError();
+		Reset(1, FLSStateFrame());
+		return;
+	}
+
+	Ar << StartState;
+
+	// Saved from the oldest to the newest frame, a loaded recording starts at the head of its buffer.
+	int32 NumFrames = Count;
+	Ar << NumFrames;
+	if (Ar.IsLoading())
+	{
+		if (NumFrames < 0 || Ar.IsError())
+		{
+			Ar.SetError();
+			Reset(1, FLSStateFrame());
+			return;
+		}
+
+		Frames.SetNum(FMath::Max(NumFrames, 1));
+		Head = 0;
+		Count = NumFrames;
+	}
+
+	for (int32 Index = 0; Index < NumFrames; ++Index)
+	{
+		FLSRecordedFrame& Frame = (*this)[Index];
+		Ar << Frame.Input << Frame.State;
+	}
+}
+
+void FLSReplayReport::CompareFrame(int32 Frame, const FLSStateFrame& Replayed, const FLSStateFrame& Golden, float YawTolerance, float SpeedTolerance, float LocationTolerance)
+{
+	++NumFrames;
+
+	const float YawError = FMath::Abs(FRotator::NormalizeAxis(Replayed.Yaw - Golden.Yaw));
+	const float SpeedError = FMath::Abs(Replayed.GetSpeed() - Golden.GetSpeed());
+	const float LocationError = FVector3f::Dist(Replayed.Location, Golden.Location);
+	MaxYawError = FMath::Max(MaxYawError, YawError);
+	MaxSpeedError = FMath::Max(MaxSpeedError, SpeedError);
+	MaxLocationError = FMath::Max(MaxLocationError, LocationError);
+
+	if (Replayed.Gait != Golden.Gait || Replayed.Stance != Golden.Stance || Replayed.RotationMode != Golden.RotationMode || Replayed.MovementState != Golden.MovementState
+		|| YawError > YawTolerance || SpeedError > SpeedTolerance || LocationError > LocationTolerance)
+	{
+		if (NumMismatches++ == 0)
+		{
+			FirstMismatchFrame = Frame;
+		}
+	}
+}
+
+FString FLSReplayReport::ToString() const
+{
+	return FString::Printf(TEXT("%s: %d frames, %d mismatches (first at %d), max error yaw %.3f speed %.3f location %.3f, %.2f ms total, %.3f ms avg, %.3f ms max per frame"), IsPassed() ? TEXT("Passed") : TEXT("Failed"),
+		NumFrames, NumMismatches, FirstMismatchFrame, MaxYawError, MaxSpeedError, MaxLocationError, TotalSeconds * 1000.0, NumFrames > 0 ? TotalSeconds * 1000.0 / NumFrames : 0.0, MaxFrameSeconds * 1000.0);
+}
@@ -0,0 +1,131 @@
+// Copyright BanMing
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/LocomotionTypes.h"
+
+/**
+ * Locomotion input of one frame, quantized: move axes to a byte, control rotation to 16 bits per axis,
+ * and the desired states packed into a single byte.
+ */
+struct LOCOMOTIONSYSTEM_API FLSInputFrame
+{
+	float DeltaTime = 0.f;
+	int8 MoveForward = 0;
+	int8 MoveRight = 0;
+	uint16 ControlPitch = 0;
+	uint16 ControlYaw = 0;
+
+	// Bits 0-1 desired gait, 2 desired stance, 3-4 desired rotation mode, 5 sprint held.
+	uint8 Toggles = 0;
+
+	void SetMoveAxes(float Forward, float Right);
+	float GetMoveForward() const;
+	float GetMoveRight() const;
+
+	void SetControlRotation(const FRotator& Rotation);
+	FRotator GetControlRotation() const;
+
+	void SetToggles(ELSGaitType DesiredGait, ELSStanceType DesiredStance, ELSRotationMode DesiredRotationMode, bool bSprintHeld);
+	ELSGaitType GetDesiredGait() const;
+	ELSStanceType GetDesiredStance() const;
+	ELSRotationMode GetDesiredRotationMode() const;
+	bool IsSprintHeld() const;
+
+	friend FArchive& operator<<(FArchive& Ar, FLSInputFrame& Frame);
+};
+
+// Locomotion state at the end of a frame, the trajectory replays are compared on.
+struct LOCOMOTIONSYSTEM_API FLSStateFrame
+{
+	FVector3f Location = FVector3f::ZeroVector;
+	FVector3f Velocity = FVector3f::ZeroVector;
+	float Yaw = 0.f;
+	uint8 Gait = 0;
+	uint8 Stance = 0;
+	uint8 RotationMode = 0;
+	uint8 MovementState = 0;
+
+	float GetSpeed() const
+	{
+		return Velocity.Size2D();
+	}
+
+	friend FArchive& operator<<(FArchive& Ar, FLSStateFrame& Frame);
+};
+
+struct LOCOMOTIONSYSTEM_API FLSRecordedFrame
+{
+	FLSInputFrame Input;
+	FLSStateFrame State;
+};
+
+/**
+ * Ring buffer of recorded frames. Once full, the oldest frame is dropped and its end state becomes the start state,
+ * so a replay can always begin from where the oldest kept frame began.
+ */
+struct LOCOMOTIONSYSTEM_API FLSLocomotionRecording
+{
+	void Reset(int32 InCapacity, const FLSStateFrame& InStartState);
+
+	FLSRecordedFrame& Add();
+
+	int32 Num() const
+	{
+		return Count;
+	}
+
+	// Frames from the oldest to the newest.
+	const FLSRecordedFrame& operator[](int32 Index) const
+	{
+		return Frames[(Head + Index) % Frames.Num()];
+	}
+
+	FLSRecordedFrame& operator[](int32 Index)
+	{
+		return Frames[(Head + Index) % Frames.Num()];
+	}
+
+	const FLSStateFrame& GetStartState() const
+	{
+		return StartState;
+	}
+
+	bool SaveToFile(const FString& FileName) const;
+	bool LoadFromFile(const FString& FileName);
+
+private:
+	void Serialize(FArchive& Ar);
+
+private:
+	TArray<FLSRecordedFrame> Frames;
+	int32 Head = 0;
+	int32 Count = 0;
+	FLSStateFrame StartState;
+};
+
+// Result of comparing a replayed trajectory with a golden one.
+struct LOCOMOTIONSYSTEM_API FLSReplayReport
+{
+	int32 NumFrames = 0;
+	int32 NumMismatches = 0;
+	int32 FirstMismatchFrame = INDEX_NONE;
+	float MaxYawError = 0.f;
+	float MaxSpeedError = 0.f;
+	float MaxLocationError = 0.f;
+
+	// Wall clock time of the replayed frames.
+	double TotalSeconds = 0.0;
+	double MaxFrameSeconds = 0.0;
+
+	bool IsPassed() const
+	{
+		return NumMismatches == 0;
+	}
+
+	// Compare one replayed frame, with the states exact and the rest within the tolerances.
+	void CompareFrame(int32 Frame, const FLSStateFrame& Replayed, const FLSStateFrame& Golden, float YawTolerance, float SpeedTolerance, float LocationTolerance);
+
+	FString ToString() const;
+};
@@ -0,0 +1,107 @@
+// Copyright BanMing
+
+#include "Data/LocomotionRules.h"
+
+#include "Kismet/KismetMathLibrary.h"
+
+ELSGaitType FLSLocomotionRules::GetAllowedGait(ELSStanceType Stance, ELSGaitType DesiredGait, bool bCanSprint)
+{
+	ELSGaitType Res = ELSGaitType::Walking;
+	if (Stance == ELSStanceType::Standing)
+	{
+		if (DesiredGait == ELSGaitType::Running)
+		{
+			Res = ELSGaitType::Running;
+		}
+		else if (DesiredGait == ELSGaitType::Sprinting && bCanSprint)
+		{
+			Res = ELSGaitType::Sprinting;
+		}
+	}
+	else if (Stance == ELSStanceType::Crouching && (DesiredGait == ELSGaitType::Running || DesiredGait == ELSGaitType::Sprinting))
+	{
+		Res = ELSGaitType::Running;
+	}
+
+	return Res;
+}
+
+ELSGaitType FLSLocomotionRules::GetActualGait(float Speed, const FMovementSettings& Settings, ELSGaitType AllowedGait)
+{
+	ELSGaitType Res = ELSGaitType::Walking;
+	const float SpeedOffset = 10.f;
+	if (Speed >= Settings.RunSpeed + SpeedOffset)
+	{
+		if (AllowedGait == ELSGaitType::Sprinting)
+		{
+			Res = ELSGaitType::Sprinting;
+		}
+		else
+		{
+			Res = ELSGaitType::Running;
+		}
+	}
+	else if (Speed >= Settings.WalkSpeed + SpeedOffset)
+	{
+		Res = ELSGaitType::Running;
+	}
+
+	return Res;
+}
+
+float FLSLocomotionRules::GetMaxSpeed(const FMovementSettings& Settings, ELSGaitType AllowedGait)
+{
+	switch (AllowedGait)
+	{
+		case ELSGaitType::Running:
+			return Settings.RunSpeed;
+		case ELSGaitType::Sprinting:
+			return Settings.SprintSpeed;
+		default:
+			return Settings.WalkSpeed;
+	}
+}
+
+float FLSLocomotionRules::GetMappedSpeed(float Speed, const FMovementSettings& Settings)
+{
+	// Mapping to the configured speeds allows you to vary the movement speeds but still use the mapped range in calculations for consistent results.
+	const float LocWalkSpeed = Settings.WalkSpeed;
+	const float LocRunSpeed = Settings.RunSpeed;
+	const float LocSprintSpeed = Settings.SprintSpeed;
+
+	const float WalkSpeed = UKismetMathLibrary::MapRangeClamped(Speed, 0.f, LocWalkSpeed, 0.f, 1.f);
+	const float RunSpeed = UKismetMathLibrary::MapRangeClamped(Speed, LocWalkSpeed, LocRunSpeed, 1.f, 2.f);
+	const float SprintSpeed = UKismetMathLibrary::MapRangeClamped(Speed, LocRunSpeed, LocSprintSpeed, 2.f, 3.);
+
+	float MapSpeed = Speed > LocWalkSpeed ? RunSpeed : WalkSpeed;
+	MapSpeed = Speed > LocRunSpeed ? SprintSpeed : MapSpeed;
+
+	return MapSpeed;
+}
+
+bool FLSLocomotionRules::CanSprint(ELSRotationMode RotationMode, float MovementInputAmount, float InputToViewYaw)
+{
+	const bool bIsOverInputAmount = MovementInputAmount > 0.9f;
+	switch (RotationMode)
+	{
+		case ELSRotationMode::VelocityDirection:
+			return bIsOverInputAmount;
+		case ELSRotationMode::LookingDirection:
+			return bIsOverInputAmount && FMath::Abs(InputToViewYaw) < 50.f;
+		default:
+			return false;
+	}
+}
+
+float FLSLocomotionRules::CalculateGroundedRotationRate(const FLSBakedMovementCurves& Curves, float MappedSpeed, float AimYawRate)
+{
+	const float CurveValue = Curves.IsValid() ? Curves.SampleRotationRate(MappedSpeed) : 1.f;
+	const float AimYawValue = UKismetMathLibrary::MapRangeClamped(AimYawRate, 0.f, 300.f, 1.f, 3.f);
+	return CurveValue * AimYawValue;
+}
+
+FRotator FLSLocomotionRules::SmoothRotation(const FRotator& ActorRotation, FRotator& InOutTargetRotation, const FRotator& Goal, float DeltaTime, float TargetInterpSpeed, float ActorInterpSpeed)
+{
+	InOutTargetRotation = FMath::RInterpConstantTo(InOutTargetRotation, Goal, DeltaTime, TargetInterpSpeed);
+	return FMath::RInterpTo(ActorRotation, InOutTargetRotation, DeltaTime, ActorInterpSpeed);
+}
@@ -0,0 +1,34 @@
+// Copyright BanMing
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/LocomotionTypes.h"
+#include "Data/MovementSettings.h"
+
+/**
+ * Gait and rotation rules of ALSCharacterBase as pure functions of the locomotion state,
+ * so the Mass LOD processors run exactly the same rules on entities as the characters do.
+ */
+struct LOCOMOTIONSYSTEM_API FLSLocomotionRules
+{
+	// Gait the character may move at with its stance and desired gait.
+	static ELSGaitType GetAllowedGait(ELSStanceType Stance, ELSGaitType DesiredGait, bool bCanSprint);
+
+	// Gait the character actually moves at, from its speed.
+	static ELSGaitType GetActualGait(float Speed, const FMovementSettings& Settings, ELSGaitType AllowedGait);
+
+	static float GetMaxSpeed(const FMovementSettings& Settings, ELSGaitType AllowedGait);
+
+	// Map the speed to 0 = stopped, 1 = the Walk Speed, 2 = the Run Speed and 3 = the Sprint Speed.
+	static float GetMappedSpeed(float Speed, const FMovementSettings& Settings);
+
+	// Sprinting needs nearly full input, and in Looking Direction input within 50 degrees of the view.
+	static bool CanSprint(ELSRotationMode RotationMode, float MovementInputAmount, float InputToViewYaw);
+
+	static float CalculateGroundedRotationRate(const FLSBakedMovementCurves& Curves, float MappedSpeed, float AimYawRate);
+
+	// Move the target rotation towards the goal at a constant rate and the actor rotation towards the target.
+	// Returns the new actor rotation.
+	static FRotator SmoothRotation(const FRotator& ActorRotation, FRotator& InOutTargetRotation, const FRotator& Goal, float DeltaTime, float TargetInterpSpeed, float ActorInterpSpeed);
+};
@@ -0,0 +1,149 @@
+// Copyright BanMing
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/LocomotionTypes.h"
+#include "Engine/EngineTypes.h"
+#include "HAL/PlatformProcess.h"
+
+#include <atomic>
+
+#include "LocomotionSnapshot.generated.h"
+
+USTRUCT(BlueprintType)
+struct FMovementEssentialInfo
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|Essential Info")
+	FVector Velocity = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|Essential Info")
+	FVector Acceleration = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|Essential Info")
+	FVector MovementInput = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|Essential Info")
+	bool bIsMoving = false;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|Essential Info")
+	bool bHasMovementInput = false;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|Essential Info")
+	float Speed = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|Essential Info")
+	float MovementInputAmount = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|Essential Info")
+	FRotator AimRotation = FRotator::ZeroRotator;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|Essential Info")
+	float AimYawRate = 0.f;
+};
+
+USTRUCT(BlueprintType)
+struct FMovementStates
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|State")
+	TEnumAsByte<enum EMovementMode> PawnMovementMode;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|State")
+	ELSMovementState MovementState = ELSMovementState::None;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|State")
+	ELSMovementState PrevMovementState = ELSMovementState::None;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|State")
+	ELSMovementAction MovementAction = ELSMovementAction::None;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|State")
+	ELSRotationMode RotationMode = ELSRotationMode::LookingDirection;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|State")
+	ELSGaitType ActualGait = ELSGaitType::Walking;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|State")
+	ELSStanceType ActualStance = ELSStanceType::Standing;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|State")
+	ELSViewMode ViewMode = ELSViewMode::ThirdPerson;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Locomotion|State")
+	ELSOverlayState OverlayState = ELSOverlayState::Default;
+};
+
+// Locomotion state of a character as of one frame.
+struct FLSLocomotionSnapshot
+{
+	FMovementEssentialInfo MovementInfo;
+	FMovementStates MovementStates;
+	FRotator ActorRotation = FRotator::ZeroRotator;
+
+	// GFrameCounter of the frame it was published in, 0 until the first one.
+	uint64 FrameNumber = 0;
+};
+
+/**
+ * The latest published snapshot behind a sequence lock. The game thread writes it in place, with the sequence odd meanwhile.
+ * Readers on other threads copy it straight into their destination and copy again if the sequence changed during the copy,
+ * so they never wait on a lock and never see a half written snapshot. The game thread cannot overlap a write and reads it in place.
+ */
+class FLSLocomotionSnapshotBuffer
+{
+public:
+	// Game thread only, no copy.
+	const FLSLocomotionSnapshot& GetLatest() const
+	{
+		check(IsInGameThread());
+		return Latest;
+	}
+
+	// Any thread. Copy calls back with the snapshot and copies what it needs out of it, again if a publish overlapped.
+	template <typename CopyFunctionType>
+	void Read(CopyFunctionType&& Copy) const
+	{
+		for (;;)
+		{
+			const uint32 SequenceBefore = Sequence.load(std::memory_order_acquire);
+			if ((SequenceBefore & 1) == 0)
+			{
+				Copy(Latest);
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (Sequence.load(std::memory_order_relaxed) == SequenceBefore)
+				{
+					return;
+				}
+			}
+			FPlatformProcess::YieldThread();
+		}
+	}
+
+	void Read(FLSLocomotionSnapshot& OutSnapshot) const
+	{
+		Read([&OutSnapshot](const FLSLocomotionSnapshot& Snapshot) { OutSnapshot = Snapshot; });
+	}
+
+	// Game thread only. The returned snapshot is published by Publish.
+	FLSLocomotionSnapshot& BeginWrite()
+	{
+		check(IsInGameThread());
+		Sequence.store(Sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		return Latest;
+	}
+
+	void Publish()
+	{
+		check(IsInGameThread());
+		Sequence.store(Sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+private:
+	FLSLocomotionSnapshot Latest;
+	std::atomic<uint32> Sequence{0};
+};
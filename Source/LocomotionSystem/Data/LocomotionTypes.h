@@ -0,0 +1,84 @@
+// Copyright BanMing
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "LocomotionTypes.generated.h"
+
+UENUM(BlueprintType)
+enum class ELSGaitType
+{
+	Walking,
+	Running,
+	Sprinting
+};
+
+UENUM(BlueprintType)
+enum class ELSStanceType
+{
+	Standing,
+	Crouching,
+};
+
+UENUM(BlueprintType)
+enum class ELSRotationMode
+{
+	VelocityDirection,
+	LookingDirection,
+	Aiming
+};
+
+UENUM(BlueprintType)
+enum class ELSViewMode
+{
+	ThirdPerson,
+	FirstPerson,
+};
+
+UENUM(BlueprintType)
+enum class ELSMovementState
+{
+	None,
+	Grounded,
+	InAir,
+	Mantling,
+	Ragdoll,
+	Climbing
+};
+
+// Custom movement modes of ULSCharacterMovementComponent, stored in its Custom Movement Mode byte.
+UENUM(BlueprintType)
+enum class ELSCustomMovementMode : uint8
+{
+	None,
+	Climbing
+};
+
+UENUM(BlueprintType)
+enum class ELSMovementAction
+{
+	None,
+	LowMantle,
+	HighMantle,
+	Rolling,
+	GettingUp
+};
+
+UENUM(BlueprintType)
+enum class ELSOverlayState
+{
+	Default,
+	Masculine,
+	Feminine,
+	Injured,
+	HandsTied,
+	Rifle,
+	Pistol1H,
+	Pistol2H,
+	Bow,
+	Torch,
+	Binoculars,
+	Box,
+	Barrel,
+};
@@ -0,0 +1,63 @@
+// Copyright BanMing
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "MantleSettings.generated.h"
+
+class UCurveVector;
+
+// How a mantle animation lines up with the ledge. The montage itself comes from the action montage set.
+USTRUCT(BlueprintType)
+struct FLSMantleAsset
+{
+	GENERATED_BODY()
+
+	// X is the position alpha towards the ledge, Y and Z the horizontal and vertical correction alphas.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	TObjectPtr<UCurveVector> PositionCorrectionCurve;
+
+	// Where the animation starts relative to the ledge, Y is the distance from the wall and Z the height below it.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	FVector StartingOffset = FVector::ZeroVector;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	float LowHeight = 0.f;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	float LowPlayRate = 1.f;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	float LowStartPosition = 0.f;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	float HighHeight = 0.f;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	float HighPlayRate = 1.f;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	float HighStartPosition = 0.f;
+};
+
+USTRUCT(BlueprintType)
+struct FLSMantleTraceSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	float MaxLedgeHeight = 250.f;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	float MinLedgeHeight = 50.f;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	float ReachDistance = 75.f;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	float ForwardTraceRadius = 30.f;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	float DownwardTraceRadius = 30.f;
+};
@@ -0,0 +1,53 @@
+// Copyright BanMing
+
+#include "Data/MovementModelAsset.h"
+
+#include "Curves/CurveFloat.h"
+#include "Curves/CurveVector.h"
+#include "UObject/ObjectSaveContext.h"
+
+const FPrimaryAssetType ULSMovementModelAsset::PrimaryAssetType = TEXT("LSMovementModel");
+
+FPrimaryAssetId ULSMovementModelAsset::GetPrimaryAssetId() const
+{
+	return FPrimaryAssetId(PrimaryAssetType, GetFName());
+}
+
+#if WITH_EDITOR
+void ULSMovementModelAsset::PreSave(FObjectPreSaveContext ObjectSaveContext)
+{
+	BakeCurves();
+	Super::PreSave(ObjectSaveContext);
+}
+
+void ULSMovementModelAsset::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+	BakeCurves();
+}
+
+void ULSMovementModelAsset::BakeCurves()
+{
+	BakedCurves.SetNum(6);
+	for (const ELSRotationMode RotationMode : {ELSRotationMode::VelocityDirection, ELSRotationMode::LookingDirection, ELSRotationMode::Aiming})
+	{
+		for (const ELSStanceType Stance : {ELSStanceType::Standing, ELSStanceType::Crouching})
+		{
+			// Editor only, the synchronous load never happens in a cooked build.
+			const FSoftMovementSettings& Settings = GetSettings(RotationMode, Stance);
+			BakedCurves[GetBakedIndex(RotationMode, Stance)].Bake(Settings.MovementCurve.LoadSynchronous(), Settings.RotationRateCurve.LoadSynchronous());
+		}
+	}
+}
+#endif
+
+const FSoftMovementSettings& ULSMovementModelAsset::GetSettings(ELSRotationMode RotationMode, ELSStanceType Stance) const
+{
+	const FSoftMovementSettings_Stance& StanceSettings = RotationMode == ELSRotationMode::VelocityDirection ? VelocityDirection : RotationMode == ELSRotationMode::LookingDirection ? LookingDirection : Aiming;
+	return Stance == ELSStanceType::Standing ? StanceSettings.Standing : StanceSettings.Crouching;
+}
+
+const FLSBakedMovementCurves& ULSMovementModelAsset::GetBakedCurves(ELSRotationMode RotationMode, ELSStanceType Stance) const
+{
+	return BakedCurves[GetBakedIndex(RotationMode, Stance)];
+}
@@ -0,0 +1,104 @@
+// Copyright BanMing
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/LocomotionTypes.h"
+#include "Data/MovementSettings.h"
+#include "Engine/DataAsset.h"
+
+#include "MovementModelAsset.generated.h"
+
+class UCurveFloat;
+class UCurveVector;
+
+USTRUCT(BlueprintType)
+struct FSoftMovementSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	float WalkSpeed = 165.f;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	float RunSpeed = 350.f;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	float SprintSpeed = 600.f;
+
+	// Only loaded in the editor to bake the curve samples.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	TSoftObjectPtr<UCurveVector> MovementCurve;
+
+	// Only loaded in the editor to bake the curve samples.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	TSoftObjectPtr<UCurveFloat> RotationRateCurve;
+};
+
+USTRUCT(BlueprintType)
+struct FSoftMovementSettings_Stance
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	FSoftMovementSettings Standing;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	FSoftMovementSettings Crouching;
+};
+
+/**
+ * Movement model as a primary asset so the Asset Manager can stream it in asynchronously.
+ * Curves are soft references that are only loaded when baking in the editor;
+ * the cooked asset carries the pre-baked samples and never pulls the curves in.
+ */
+UCLASS(BlueprintType)
+class LOCOMOTIONSYSTEM_API ULSMovementModelAsset : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	static const FPrimaryAssetType PrimaryAssetType;
+
+	virtual FPrimaryAssetId GetPrimaryAssetId() const override;
+
+#if WITH_EDITOR
+	virtual void PreSave(FObjectPreSaveContext ObjectSaveContext) override;
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+	// Get the authored settings for the Rotation Mode and Stance.
+	const FSoftMovementSettings& GetSettings(ELSRotationMode RotationMode, ELSStanceType Stance) const;
+
+	// Get the baked curves for the Rotation Mode and Stance. Indexed the same way as the movement model lookup.
+	const FLSBakedMovementCurves& GetBakedCurves(ELSRotationMode RotationMode, ELSStanceType Stance) const;
+
+	bool HasBakedCurves() const
+	{
+		return BakedCurves.Num() == 6;
+	}
+
+	static int32 GetBakedIndex(ELSRotationMode RotationMode, ELSStanceType Stance)
+	{
+		return static_cast<int32>(RotationMode) * 2 + static_cast<int32>(Stance);
+	}
+
+protected:
+#if WITH_EDITOR
+	void BakeCurves();
+#endif
+
+protected:
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Movement Model")
+	FSoftMovementSettings_Stance VelocityDirection;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Movement Model")
+	FSoftMovementSettings_Stance LookingDirection;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Movement Model")
+	FSoftMovementSettings_Stance Aiming;
+
+	// Baked in the editor on save, one entry per Rotation Mode and Stance.
+	UPROPERTY(VisibleAnywhere, Category = "Movement Model|Baked")
+	TArray<FLSBakedMovementCurves> BakedCurves;
+};
@@ -0,0 +1,251 @@
+// Copyright BanMing
+
+#include "Data/MovementModelRegistry.h"
+
+#include "Data/MovementModelAsset.h"
+#include "Engine/AssetManager.h"
+#include "LocomotionSystem.h"
+
+static constexpr ELSRotationMode GRotationModes[] = {ELSRotationMode::VelocityDirection, ELSRotationMode::LookingDirection, ELSRotationMode::Aiming};
+static constexpr ELSStanceType GStances[] = {ELSStanceType::Standing, ELSStanceType::Crouching};
+
+FLSMovementModel::FLSMovementModel(const FMovementSettings_State& InSettingsState)
+	: SettingsState(InSettingsState)
+{
+	BuildLookup();
+
+	for (const ELSRotationMode RotationMode : GRotationModes)
+	{
+		for (const ELSStanceType Stance : GStances)
+		{
+			const FMovementSettings& Settings = GetSettings(RotationMode, Stance);
+			BakedCurves[static_cast<int32>(RotationMode)][static_cast<int32>(Stance)].Bake(Settings.MovementCurve, Settings.RotationRateCurve);
+		}
+	}
+}
+
+FLSMovementModel::FLSMovementModel(const ULSMovementModelAsset& Asset)
+{
+	BuildLookup();
+
+	for (const ELSRotationMode RotationMode : GRotationModes)
+	{
+		for (const ELSStanceType Stance : GStances)
+		{
+			// Only the speeds are copied, the curves stay unloaded and the baked samples are used instead.
+			const FSoftMovementSettings& Source = Asset.GetSettings(RotationMode, Stance);
+			FMovementSettings& Settings = *SettingsLookup[static_cast<int32>(RotationMode)][static_cast<int32>(Stance)];
+			Settings.WalkSpeed = Source.WalkSpeed;
+			Settings.RunSpeed = Source.RunSpeed;
+			Settings.SprintSpeed = Source.SprintSpeed;
+
+			BakedCurves[static_cast<int32>(RotationMode)][static_cast<int32>(Stance)] = Asset.GetBakedCurves(RotationMode, Stance);
+		}
+	}
+}
+
+void FLSMovementModel::BuildLookup()
+{
+	FMovementSettings_Stance* Stances[NumRotationModes] = {&SettingsState.VelocityDirection, &SettingsState.LookingDirection, &SettingsState.Aiming};
+	for (int32 RotationIndex = 0; RotationIndex < NumRotationModes; ++RotationIndex)
+	{
+		SettingsLookup[RotationIndex][static_cast<int32>(ELSStanceType::Standing)] = &Stances[RotationIndex]->Standing;
+		SettingsLookup[RotationIndex][static_cast<int32>(ELSStanceType::Crouching)] = &Stances[RotationIndex]->Crouching;
+	}
+}
+
+void ULSMovementModelRegistry::Deinitialize()
+{
+	for (const TPair<TObjectKey<UDataTable>, FDelegateHandle>& Pair : WatchedTables)
+	{
+		if (UDataTable* Table = Pair.Key.ResolveObjectPtr())
+		{
+			Table->OnDataTableChanged().Remove(Pair.Value);
+		}
+	}
+	WatchedTables.Empty();
+	Entries.Empty();
+
+	for (TPair<FSoftObjectPath, FPendingLoad>& Pair : PendingLoads)
+	{
+		if (Pair.Value.Handle.IsValid())
+		{
+			Pair.Value.Handle->CancelHandle();
+		}
+	}
+	PendingLoads.Empty();
+
+	Super::Deinitialize();
+}
+
+FLSMovementModelHandle ULSMovementModelRegistry::FindModel(const FModelKey& Key) const
+{
+	if (const TWeakPtr<FLSMovementModelEntry, ESPMode::ThreadSafe>* Existing = Entries.Find(Key))
+	{
+		return Existing->Pin();
+	}
+	return nullptr;
+}
+
+FLSMovementModelHandle ULSMovementModelRegistry::FindOrAddModel(const FDataTableRowHandle& RowHandle)
+{
+	check(IsInGameThread());
+
+	const UDataTable* Table = RowHandle.DataTable;
+	if (!IsValid(Table))
+	{
+		return nullptr;
+	}
+
+	const FModelKey Key(Table, RowHandle.RowName);
+	if (FLSMovementModelHandle Existing = FindModel(Key))
+	{
+		return Existing;
+	}
+
+	const FMovementSettings_State* Row = Table->FindRow<FMovementSettings_State>(RowHandle.RowName, TEXT("ULSMovementModelRegistry::FindOrAddModel"));
+	if (Row == nullptr)
+	{
+		return nullptr;
+	}
+
+	TSharedPtr<FLSMovementModelEntry, ESPMode::ThreadSafe> Entry = MakeShared<FLSMovementModelEntry, ESPMode::ThreadSafe>();
+	Entry->Model = MakeShared<FLSMovementModel, ESPMode::ThreadSafe>(*Row);
+	Entries.Add(Key, Entry);
+
+#if WITH_EDITOR
+	// Rebuild every model of this table when it is edited or reimported.
+	const TObjectKey<UDataTable> TableKey(Table);
+	if (!WatchedTables.Contains(TableKey))
+	{
+		UDataTable* MutableTable = const_cast<UDataTable*>(Table);
+		WatchedTables.Add(TableKey, MutableTable->OnDataTableChanged().AddUObject(this, &ThisClass::HandleDataTableChanged, TableKey));
+	}
+#endif
+
+	return Entry;
+}
+
+FLSMovementModelHandle ULSMovementModelRegistry::FindOrAddModel(const ULSMovementModelAsset* Asset)
+{
+	check(IsInGameThread());
+
+	if (!IsValid(Asset))
+	{
+		return nullptr;
+	}
+
+	const FModelKey Key(Asset, NAME_None);
+	if (FLSMovementModelHandle Existing = FindModel(Key))
+	{
+		return Existing;
+	}
+
+	if (!Asset->HasBakedCurves())
+	{
+		UE_LOG(LogLocomotion, Error, TEXT("Movement model asset '%s' has no baked curves, resave it in the editor."), *Asset->GetName());
+		return nullptr;
+	}
+
+	// The model only keeps the baked data, so the asset is free to unload once every model is built.
+	TSharedPtr<FLSMovementModelEntry, ESPMode::ThreadSafe> Entry = MakeShared<FLSMovementModelEntry, ESPMode::ThreadSafe>();
+	Entry->Model = MakeShared<FLSMovementModel, ESPMode::ThreadSafe>(*Asset);
+	Entries.Add(Key, Entry);
+
+	return Entry;
+}
+
+void ULSMovementModelRegistry::RequestModelAsync(const TSoftObjectPtr<ULSMovementModelAsset>& Asset, FOnMovementModelReady OnReady)
+{
+	check(IsInGameThread());
+
+	if (Asset.IsNull())
+	{
+		OnReady.ExecuteIfBound(nullptr);
+		return;
+	}
+
+	if (const ULSMovementModelAsset* Loaded = Asset.Get())
+	{
+		OnReady.ExecuteIfBound(FindOrAddModel(Loaded));
+		return;
+	}
+
+	const FSoftObjectPath AssetPath = Asset.ToSoftObjectPath();
+	if (FPendingLoad* Pending = PendingLoads.Find(AssetPath))
+	{
+		Pending->Callbacks.Add(MoveTemp(OnReady));
+		return;
+	}
+
+	PendingLoads.Add(AssetPath).Callbacks.Add(MoveTemp(OnReady));
+	TSharedPtr<FStreamableHandle> Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(AssetPath, FStreamableDelegate::CreateUObject(this, &ThisClass::HandleAssetLoaded, AssetPath));
+
+	// The delegate fires inside the request if the package was already in memory, which removes the pending load.
+	if (FPendingLoad* Pending = PendingLoads.Find(AssetPath))
+	{
+		if (Handle.IsValid())
+		{
+			Pending->Handle = MoveTemp(Handle);
+		}
+		else
+		{
+			HandleAssetLoaded(AssetPath);
+		}
+	}
+}
+
+void ULSMovementModelRegistry::HandleAssetLoaded(FSoftObjectPath AssetPath)
+{
+	FPendingLoad Pending;
+	if (!PendingLoads.RemoveAndCopyValue(AssetPath, Pending))
+	{
+		return;
+	}
+
+	const ULSMovementModelAsset* Asset = Cast<ULSMovementModelAsset>(AssetPath.ResolveObject());
+	if (Asset == nullptr)
+	{
+		UE_LOG(LogLocomotion, Error, TEXT("Failed to load movement model asset '%s'."), *AssetPath.ToString());
+	}
+
+	const FLSMovementModelHandle Model = FindOrAddModel(Asset);
+	for (FOnMovementModelReady& Callback : Pending.Callbacks)
+	{
+		Callback.ExecuteIfBound(Model);
+	}
+}
+
+void ULSMovementModelRegistry::HandleDataTableChanged(TObjectKey<UDataTable> TableKey)
+{
+	const UDataTable* Table = TableKey.ResolveObjectPtr();
+	if (Table == nullptr)
+	{
+		return;
+	}
+
+	const FObjectKey TableObjectKey(Table);
+	for (auto It = Entries.CreateIterator(); It; ++It)
+	{
+		TSharedPtr<FLSMovementModelEntry, ESPMode::ThreadSafe> Entry = It->Value.Pin();
+		if (!Entry.IsValid())
+		{
+			It.RemoveCurrent();
+			continue;
+		}
+
+		if (It->Key.Key != TableObjectKey)
+		{
+			continue;
+		}
+
+		const FMovementSettings_State* Row = Table->FindRow<FMovementSettings_State>(It->Key.Value, TEXT("ULSMovementModelRegistry::HandleDataTableChanged"), false);
+		if (Row == nullptr)
+		{
+			UE_LOG(LogLocomotion, Warning, TEXT("Movement Model row '%s' was removed from '%s', keeping the previous model."), *It->Key.Value.ToString(), *Table->GetName());
+			continue;
+		}
+
+		Entry->Model = MakeShared<FLSMovementModel, ESPMode::ThreadSafe>(*Row);
+	}
+}
@@ -0,0 +1,129 @@
+// Copyright BanMing
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/LocomotionTypes.h"
+#include "Data/MovementSettings.h"
+#include "Engine/DataTable.h"
+#include "Subsystems/EngineSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "UObject/SoftObjectPtr.h"
+
+#include "MovementModelRegistry.generated.h"
+
+/**
+ * Immutable movement model built once from a Movement Model row and shared by every character using that row.
+ * Derived data is baked at build time so characters only do lookups at runtime.
+ */
+class LOCOMOTIONSYSTEM_API FLSMovementModel
+{
+public:
+	// Build from a Data Table row, baking the curves it references.
+	explicit FLSMovementModel(const FMovementSettings_State& InSettingsState);
+
+	// Build from a cooked movement model asset, using its pre-baked curve samples.
+	explicit FLSMovementModel(const class ULSMovementModelAsset& Asset);
+
+	FLSMovementModel(const FLSMovementModel&) = delete;
+	FLSMovementModel& operator=(const FLSMovementModel&) = delete;
+
+	const FMovementSettings_State& GetSettingsState() const
+	{
+		return SettingsState;
+	}
+
+	// Get the settings block for the current Rotation Mode and Stance without walking the nested structs.
+	const FMovementSettings& GetSettings(ELSRotationMode RotationMode, ELSStanceType Stance) const
+	{
+		return *SettingsLookup[static_cast<int32>(RotationMode)][static_cast<int32>(Stance)];
+	}
+
+	// Get the baked Movement and Rotation Rate curves for the current Rotation Mode and Stance.
+	const FLSBakedMovementCurves& GetBakedCurves(ELSRotationMode RotationMode, ELSStanceType Stance) const
+	{
+		return BakedCurves[static_cast<int32>(RotationMode)][static_cast<int32>(Stance)];
+	}
+
+private:
+	void BuildLookup();
+
+private:
+	static constexpr int32 NumRotationModes = 3;
+	static constexpr int32 NumStances = 2;
+
+	FMovementSettings_State SettingsState;
+
+	// Points into SettingsState, indexed by [RotationMode][Stance].
+	FMovementSettings* SettingsLookup[NumRotationModes][NumStances];
+
+	FLSBakedMovementCurves BakedCurves[NumRotationModes][NumStances];
+};
+
+/**
+ * The slot every user of a Movement Model row points at.
+ * Hot reloading swaps the model inside the slot, so all characters see the new data on the same frame.
+ */
+class LOCOMOTIONSYSTEM_API FLSMovementModelEntry
+{
+public:
+	const FLSMovementModel* Get() const
+	{
+		return Model.Get();
+	}
+
+private:
+	friend class ULSMovementModelRegistry;
+
+	TSharedPtr<const FLSMovementModel, ESPMode::ThreadSafe> Model;
+};
+
+using FLSMovementModelHandle = TSharedPtr<const FLSMovementModelEntry, ESPMode::ThreadSafe>;
+
+DECLARE_DELEGATE_OneParam(FOnMovementModelReady, FLSMovementModelHandle);
+
+/**
+ * Registry of shared movement models keyed by Movement Model row handle.
+ * Entries are ref-counted by the characters holding them and released once the last user is gone.
+ */
+UCLASS()
+class LOCOMOTIONSYSTEM_API ULSMovementModelRegistry : public UEngineSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// Find the shared model for the row, building it on first use. Returns null if the row does not exist.
+	FLSMovementModelHandle FindOrAddModel(const FDataTableRowHandle& RowHandle);
+
+	// Find the shared model for a loaded movement model asset. Returns null if the asset has not been baked.
+	FLSMovementModelHandle FindOrAddModel(const class ULSMovementModelAsset* Asset);
+
+	// Stream the movement model asset in through the Asset Manager and call back once the model is ready.
+	// Calls back immediately if the model is already built. The callback receives null if loading failed.
+	void RequestModelAsync(const TSoftObjectPtr<class ULSMovementModelAsset>& Asset, FOnMovementModelReady OnReady);
+
+private:
+	// Data Table rows are keyed by table and row name, assets by the asset and NAME_None.
+	using FModelKey = TPair<FObjectKey, FName>;
+
+	FLSMovementModelHandle FindModel(const FModelKey& Key) const;
+	void HandleAssetLoaded(FSoftObjectPath AssetPath);
+
+	void HandleDataTableChanged(TObjectKey<UDataTable> TableKey);
+
+private:
+	TMap<FModelKey, TWeakPtr<FLSMovementModelEntry, ESPMode::ThreadSafe>> Entries;
+
+	// Tables we are listening to for hot reload.
+	TMap<TObjectKey<UDataTable>, FDelegateHandle> WatchedTables;
+
+	struct FPendingLoad
+	{
+		TSharedPtr<struct FStreamableHandle> Handle;
+		TArray<FOnMovementModelReady> Callbacks;
+	};
+
+	TMap<FSoftObjectPath, FPendingLoad> PendingLoads;
+};
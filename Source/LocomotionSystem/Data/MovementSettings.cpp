@@ -1,3 +1,62 @@
 // Copyright BanMing
 
 #include "MovementSettings.h"
+
+#include "Curves/CurveFloat.h"
+#include "Curves/CurveVector.h"
+
+namespace
+{
+void GetSampleIndices(float MappedSpeed, int32& OutIndex, float& OutAlpha)
+{
+	const float Position = FMath::Clamp(MappedSpeed, 0.f, FLSBakedMovementCurves::MaxMappedSpeed) * FLSBakedMovementCurves::SamplesPerMappedSpeed;
+	OutIndex = FMath::Min(FMath::FloorToInt32(Position), FLSBakedMovementCurves::NumSamples - 2);
+	OutAlpha = Position - OutIndex;
+}
+
+// Tables baked before the grid was introduced are snapped when sampled.
+FIntVector GetQuantizedMovement(const FVector3f& Sample)
+{
+	return FIntVector(FMath::RoundToInt32(Sample.X / FLSBakedMovementCurves::AccelerationStep), FMath::RoundToInt32(Sample.Y / FLSBakedMovementCurves::AccelerationStep),
+		FMath::RoundToInt32(Sample.Z / FLSBakedMovementCurves::FrictionStep));
+}
+
+int32 LerpQuantized(int32 A, int32 B, int32 Alpha)
+{
+	return A + static_cast<int32>(static_cast<int64>(B - A) * Alpha / FLSBakedMovementCurves::AlphaSteps);
+}
+}	 // namespace
+
+void FLSBakedMovementCurves::Bake(const UCurveVector* MovementCurve, const UCurveFloat* RotationRateCurve)
+{
+	MovementSamples.SetNumUninitialized(NumSamples);
+	RotationRateSamples.SetNumUninitialized(NumSamples);
+
+	for (int32 Index = 0; Index < NumSamples; ++Index)
+	{
+		const float MappedSpeed = static_cast<float>(Index) / SamplesPerMappedSpeed;
+		const FIntVector Movement = MovementCurve ? GetQuantizedMovement(FVector3f(MovementCurve->GetVectorValue(MappedSpeed))) : FIntVector::ZeroValue;
+		MovementSamples[Index] = FVector3f(Movement.X * AccelerationStep, Movement.Y * AccelerationStep, Movement.Z * FrictionStep);
+		RotationRateSamples[Index] = RotationRateCurve ? RotationRateCurve->GetFloatValue(MappedSpeed) : 0.f;
+	}
+}
+
+FVector FLSBakedMovementCurves::SampleMovement(float MappedSpeed) const
+{
+	// Snapping the speed first leaves only integer math, which no compiler or platform evaluates differently.
+	const int32 Position = FMath::RoundToInt32(FMath::Clamp(MappedSpeed, 0.f, MaxMappedSpeed) * (SamplesPerMappedSpeed * AlphaSteps));
+	const int32 Index = FMath::Min(Position / AlphaSteps, NumSamples - 2);
+	const int32 Alpha = Position - Index * AlphaSteps;
+
+	const FIntVector A = GetQuantizedMovement(MovementSamples[Index]);
+	const FIntVector B = GetQuantizedMovement(MovementSamples[Index + 1]);
+	return FVector(LerpQuantized(A.X, B.X, Alpha) * AccelerationStep, LerpQuantized(A.Y, B.Y, Alpha) * AccelerationStep, LerpQuantized(A.Z, B.Z, Alpha) * FrictionStep);
+}
+
+float FLSBakedMovementCurves::SampleRotationRate(float MappedSpeed) const
+{
+	int32 Index;
+	float Alpha;
+	GetSampleIndices(MappedSpeed, Index, Alpha);
+	return FMath::Lerp(RotationRateSamples[Index], RotationRateSamples[Index + 1], Alpha);
+}
@@ -54,3 +54,42 @@ struct FMovementSettings_State : public FTableRowBase
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
 	FMovementSettings_Stance Aiming;
 };
+
+/**
+ * Movement and Rotation Rate curves pre-sampled over the mapped speed range (0 = stopped, 3 = Sprint Speed).
+ * Sampling the baked table never touches the curve assets, so they do not need to be resident at runtime.
+ * Movement samples sit on a fixed grid and are interpolated in fixed point, so the same curves sampled at the same speed
+ * give the same acceleration, braking deceleration and ground friction on the client and the server.
+ */
+USTRUCT()
+struct LOCOMOTIONSYSTEM_API FLSBakedMovementCurves
+{
+	GENERATED_BODY()
+
+	static constexpr float MaxMappedSpeed = 3.f;
+	static constexpr int32 SamplesPerMappedSpeed = 16;
+	static constexpr int32 NumSamples = static_cast<int32>(MaxMappedSpeed) * SamplesPerMappedSpeed + 1;
+
+	// Grid of the movement samples: acceleration and braking deceleration in whole cm/s^2, ground friction in 1/64ths.
+	static constexpr float AccelerationStep = 1.f;
+	static constexpr float FrictionStep = 1.f / 64.f;
+
+	// Steps between two samples the mapped speed is snapped to.
+	static constexpr int32 AlphaSteps = 256;
+
+	UPROPERTY()
+	TArray<FVector3f> MovementSamples;
+
+	UPROPERTY()
+	TArray<float> RotationRateSamples;
+
+	void Bake(const class UCurveVector* MovementCurve, const class UCurveFloat* RotationRateCurve);
+
+	bool IsValid() const
+	{
+		return MovementSamples.Num() == NumSamples && RotationRateSamples.Num() == NumSamples;
+	}
+
+	FVector SampleMovement(float MappedSpeed) const;
+	float SampleRotationRate(float MappedSpeed) const;
+};
@@ -0,0 +1,32 @@
+// Copyright BanMing
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/LocomotionTypes.h"
+#include "Engine/DataAsset.h"
+
+#include "OverlayLayerSet.generated.h"
+
+class UAnimInstance;
+
+/**
+ * Linked anim layer class for each Overlay State.
+ * The classes are soft references so only the overlays characters are actually using stay resident.
+ */
+UCLASS(BlueprintType)
+class LOCOMOTIONSYSTEM_API ULSOverlayLayerSet : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	TSoftClassPtr<UAnimInstance> GetLayerClass(ELSOverlayState OverlayState) const
+	{
+		const TSoftClassPtr<UAnimInstance>* LayerClass = Layers.Find(OverlayState);
+		return LayerClass ? *LayerClass : TSoftClassPtr<UAnimInstance>();
+	}
+
+protected:
+	UPROPERTY(EditDefaultsOnly, Category = "Overlay")
+	TMap<ELSOverlayState, TSoftClassPtr<UAnimInstance>> Layers;
+};
@@ -0,0 +1,89 @@
+// Copyright BanMing
+
+#include "Data/TurnInPlaceSet.h"
+
+#include "Animation/AnimSequenceBase.h"
+#include "UObject/ObjectSaveContext.h"
+
+void FLSTurnInPlaceTable::Build(const UAnimSequenceBase* Animation, const FName& CurveName)
+{
+	Yaw.Reset();
+	if (Animation == nullptr)
+	{
+		return;
+	}
+
+	const float Length = Animation->GetPlayLength();
+	const int32 NumSamples = FMath::CeilToInt32(Length * SampleRate) + 1;
+	Yaw.Reserve(NumSamples);
+
+	// Integrate the per frame rotation with the trapezoid rule, so the table holds the yaw reached at each sample.
+	float Accumulated = 0.f;
+	float PrevRate = Animation->EvaluateCurveData(CurveName, 0.f);
+	Yaw.Add(0.f);
+	for (int32 Index = 1; Index < NumSamples; ++Index)
+	{
+		const float PrevTime = (Index - 1) / SampleRate;
+		const float Time = FMath::Min(Index / SampleRate, Length);
+		const float Rate = Animation->EvaluateCurveData(CurveName, Time);
+		Accumulated += (PrevRate + Rate) * 0.5f * (Time - PrevTime) * SampleRate;
+		Yaw.Add(Accumulated);
+		PrevRate = Rate;
+	}
+}
+
+float FLSTurnInPlaceTable::Sample(float Time) const
+{
+	if (!IsValid())
+	{
+		return 0.f;
+	}
+
+	const float Position = FMath::Clamp(Time * SampleRate, 0.f, static_cast<float>(Yaw.Num() - 1));
+	const int32 Index = FMath::Min(FMath::FloorToInt32(Position), Yaw.Num() - 2);
+	return FMath::Lerp(Yaw[Index], Yaw[Index + 1], Position - Index);
+}
+
+#if WITH_EDITOR
+void ULSTurnInPlaceSet::PreSave(FObjectPreSaveContext ObjectSaveContext)
+{
+	BuildTables(false);
+	Super::PreSave(ObjectSaveContext);
+}
+
+void ULSTurnInPlaceSet::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+	BuildTables(false);
+}
+#endif
+
+void ULSTurnInPlaceSet::BuildMissingTables()
+{
+	check(IsInGameThread());
+	BuildTables(true);
+}
+
+const FLSTurnInPlaceAsset& ULSTurnInPlaceSet::SelectAsset(float TurnAngle, ELSStanceType Stance) const
+{
+	const FLSTurnInPlaceAsset_Stance& Assets = Stance == ELSStanceType::Crouching ? Crouching : Standing;
+	if (FMath::Abs(TurnAngle) < Turn180Threshold)
+	{
+		return TurnAngle < 0.f ? Assets.TurnLeft90 : Assets.TurnRight90;
+	}
+	return TurnAngle < 0.f ? Assets.TurnLeft180 : Assets.TurnRight180;
+}
+
+void ULSTurnInPlaceSet::BuildTables(bool bOnlyMissing)
+{
+	for (FLSTurnInPlaceAsset_Stance* Assets : {&Standing, &Crouching})
+	{
+		for (FLSTurnInPlaceAsset* Asset : {&Assets->TurnLeft90, &Assets->TurnRight90, &Assets->TurnLeft180, &Assets->TurnRight180})
+		{
+			if (!bOnlyMissing || (Asset->Animation && !Asset->Table.IsValid()))
+			{
+				Asset->Table.Build(Asset->Animation, RotationAmountCurve);
+			}
+		}
+	}
+}
@@ -0,0 +1,131 @@
+// Copyright BanMing
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/LocomotionTypes.h"
+#include "Engine/DataAsset.h"
+
+#include "TurnInPlaceSet.generated.h"
+
+class UAnimSequenceBase;
+
+/**
+ * Accumulated yaw of a turn in place animation, sampled at a fixed rate from its Rotation Amount curve.
+ * Sampling it at the montage time gives the rotation to apply without evaluating the pose.
+ */
+USTRUCT()
+struct LOCOMOTIONSYSTEM_API FLSTurnInPlaceTable
+{
+	GENERATED_BODY()
+
+	// The Rotation Amount curve is authored as degrees per frame at this rate.
+	static constexpr float SampleRate = 30.f;
+
+	void Build(const UAnimSequenceBase* Animation, const FName& CurveName);
+
+	bool IsValid() const
+	{
+		return Yaw.Num() > 1;
+	}
+
+	// Accumulated yaw at the time, clamped to the length of the animation.
+	float Sample(float Time) const;
+
+	UPROPERTY()
+	TArray<float> Yaw;
+};
+
+USTRUCT(BlueprintType)
+struct FLSTurnInPlaceAsset
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	TObjectPtr<UAnimSequenceBase> Animation;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	float AnimatedAngle = 0.f;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	FName SlotName = TEXT("(N) Turn/Rotate");
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	float PlayRate = 1.f;
+
+	// Scale the applied rotation so the turn ends exactly on the target angle.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	bool bScaleTurnAngle = true;
+
+	// Baked in the editor on save.
+	UPROPERTY(VisibleAnywhere, Category = "Baked")
+	FLSTurnInPlaceTable Table;
+};
+
+USTRUCT(BlueprintType)
+struct FLSTurnInPlaceAsset_Stance
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	FLSTurnInPlaceAsset TurnLeft90;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	FLSTurnInPlaceAsset TurnRight90;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	FLSTurnInPlaceAsset TurnLeft180;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+	FLSTurnInPlaceAsset TurnRight180;
+};
+
+/**
+ * Turn in place animations per Stance and the thresholds used to pick them.
+ * The yaw tables are baked when the set is saved or edited, loading never touches the animations.
+ */
+UCLASS(BlueprintType)
+class LOCOMOTIONSYSTEM_API ULSTurnInPlaceSet : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+#if WITH_EDITOR
+	virtual void PreSave(FObjectPreSaveContext ObjectSaveContext) override;
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+	// Build the tables a set saved before they were baked is missing. Game thread only, it evaluates the animations.
+	void BuildMissingTables();
+
+	// Pick the asset for a turn of TurnAngle degrees, negative turns to the left.
+	const FLSTurnInPlaceAsset& SelectAsset(float TurnAngle, ELSStanceType Stance) const;
+
+protected:
+	void BuildTables(bool bOnlyMissing);
+
+public:
+	UPROPERTY(EditDefaultsOnly, Category = "Turn In Place")
+	FLSTurnInPlaceAsset_Stance Standing;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Turn In Place")
+	FLSTurnInPlaceAsset_Stance Crouching;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Turn In Place")
+	FName RotationAmountCurve = TEXT("RotationAmount");
+
+	UPROPERTY(EditDefaultsOnly, Category = "Turn In Place")
+	float TurnCheckMinAngle = 45.f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Turn In Place")
+	float Turn180Threshold = 130.f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Turn In Place")
+	float AimYawRateLimit = 50.f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Turn In Place")
+	float MinAngleDelay = 0.75f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Turn In Place")
+	float MaxAngleDelay = 0.f;
+};
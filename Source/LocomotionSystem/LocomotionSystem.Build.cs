@@ -9,6 +9,6 @@ public class LocomotionSystem : ModuleRules
         PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
         PublicIncludePaths.Add("LocomotionSystem");
 
-        PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "EnhancedInput" });
+        PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "EnhancedInput", "PhysicsCore", "AnimationBudgetAllocator", "AnimationSharing", "MassEntity", "MassCommon", "AIModule", "GameplayTasks" });
     }
 }
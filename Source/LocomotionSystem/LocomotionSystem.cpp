@@ -3,5 +3,7 @@
 #include "LocomotionSystem.h"
 #include "Modules/ModuleManager.h"
 
+DEFINE_LOG_CATEGORY(LogLocomotion);
+
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, LocomotionSystem, "LocomotionSystem" );
  
\ No newline at end of file
@@ -0,0 +1,59 @@
+// Copyright BanMing
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/LocomotionTypes.h"
+#include "Data/MovementModelRegistry.h"
+#include "MassEntityTypes.h"
+
+#include "LSMassFragments.generated.h"
+
+class ALSCharacterBase;
+
+// Locomotion state an LS character carries over while it is represented as a Mass entity.
+USTRUCT()
+struct LOCOMOTIONSYSTEM_API FLSLocomotionFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	ELSGaitType DesiredGait = ELSGaitType::Running;
+	ELSGaitType Gait = ELSGaitType::Walking;
+	ELSStanceType Stance = ELSStanceType::Standing;
+	ELSRotationMode RotationMode = ELSRotationMode::LookingDirection;
+	ELSOverlayState OverlayState = ELSOverlayState::Default;
+
+	FVector Velocity = FVector::ZeroVector;
+
+	// Input direction scaled by the input amount, kept from the character or written by whatever steers the crowd.
+	FVector MovementInput = FVector::ZeroVector;
+
+	FRotator TargetRotation = FRotator::ZeroRotator;
+};
+
+// The actor the entity was converted from, parked until the entity turns back into it.
+USTRUCT()
+struct LOCOMOTIONSYSTEM_API FLSMassParkedCharacterFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	TWeakObjectPtr<ALSCharacterBase> Character;
+};
+
+// Character class to spawn back if the parked actor is gone, and its movement model, shared by every entity of the class.
+USTRUCT()
+struct LOCOMOTIONSYSTEM_API FLSMassCharacterFragment : public FMassConstSharedFragment
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TSubclassOf<ALSCharacterBase> CharacterClass;
+
+	FLSMovementModelHandle MovementModel;
+};
+
+USTRUCT()
+struct LOCOMOTIONSYSTEM_API FLSMassLocomotionTag : public FMassTag
+{
+	GENERATED_BODY()
+};
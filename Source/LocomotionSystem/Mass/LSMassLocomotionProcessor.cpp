@@ -0,0 +1,75 @@
+// Copyright BanMing
+
+#include "Mass/LSMassLocomotionProcessor.h"
+
+#include "Data/LocomotionRules.h"
+#include "Mass/LSMassFragments.h"
+#include "MassCommonFragments.h"
+#include "MassCommonTypes.h"
+#include "MassExecutionContext.h"
+
+ULSMassLocomotionProcessor::ULSMassLocomotionProcessor()
+	: EntityQuery(*this)
+{
+	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::All);
+	ExecutionOrder.ExecuteInGroup = UE::Mass::ProcessorGroupNames::Movement;
+}
+
+void ULSMassLocomotionProcessor::ConfigureQueries()
+{
+	EntityQuery.AddRequirement<FTransformFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddRequirement<FLSLocomotionFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddConstSharedRequirement<FLSMassCharacterFragment>();
+	EntityQuery.AddTagRequirement<FLSMassLocomotionTag>(EMassFragmentPresence::All);
+}
+
+void ULSMassLocomotionProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	EntityQuery.ForEachEntityChunk(EntityManager, Context, [](FMassExecutionContext& Context) {
+		const FLSMassCharacterFragment& Character = Context.GetConstSharedFragment<FLSMassCharacterFragment>();
+		const FLSMovementModel* Model = Character.MovementModel.IsValid() ? Character.MovementModel->Get() : nullptr;
+		if (Model == nullptr)
+		{
+			return;
+		}
+
+		const TArrayView<FTransformFragment> Transforms = Context.GetMutableFragmentView<FTransformFragment>();
+		const TArrayView<FLSLocomotionFragment> LocomotionList = Context.GetMutableFragmentView<FLSLocomotionFragment>();
+		const float DeltaTime = Context.GetDeltaTimeSeconds();
+
+		for (int32 Index = 0; Index < Context.GetNumEntities(); ++Index)
+		{
+			FLSLocomotionFragment& Locomotion = LocomotionList[Index];
+			FTransform& Transform = Transforms[Index].GetMutableTransform();
+
+			const FMovementSettings& Settings = Model->GetSettings(Locomotion.RotationMode, Locomotion.Stance);
+			const FLSBakedMovementCurves& Curves = Model->GetBakedCurves(Locomotion.RotationMode, Locomotion.Stance);
+
+			// Entities have no view to compare the input against, so Looking Direction sprints like Velocity Direction.
+			const float InputAmount = FMath::Min(Locomotion.MovementInput.Size2D(), 1.f);
+			const bool bHasMovementInput = InputAmount > 0.f;
+			const bool bCanSprint = bHasMovementInput && FLSLocomotionRules::CanSprint(Locomotion.RotationMode, InputAmount, 0.f);
+			const ELSGaitType AllowedGait = FLSLocomotionRules::GetAllowedGait(Locomotion.Stance, Locomotion.DesiredGait, bCanSprint);
+
+			// Accelerate and brake with the movement curve the character movement component would be given.
+			const float Speed = Locomotion.Velocity.Size2D();
+			const float MappedSpeed = FLSLocomotionRules::GetMappedSpeed(Speed, Settings);
+			const FVector CurveValue = Curves.IsValid() ? Curves.SampleMovement(MappedSpeed) : FVector(2000.f, 2000.f, 8.f);
+			const FVector DesiredVelocity = FVector(Locomotion.MovementInput.X, Locomotion.MovementInput.Y, 0.f).GetClampedToMaxSize(1.f) * FLSLocomotionRules::GetMaxSpeed(Settings, AllowedGait);
+			Locomotion.Velocity = FMath::VInterpConstantTo(Locomotion.Velocity, DesiredVelocity, DeltaTime, bHasMovementInput ? CurveValue.X : CurveValue.Y);
+
+			const float NewSpeed = Locomotion.Velocity.Size2D();
+			Locomotion.Gait = FLSLocomotionRules::GetActualGait(NewSpeed, Settings, AllowedGait);
+			Transform.AddToTranslation(Locomotion.Velocity * DeltaTime);
+
+			// Without a view to face, every rotation mode turns towards the velocity like Velocity Direction.
+			if ((NewSpeed > 1.f && bHasMovementInput) || NewSpeed > 150.f)
+			{
+				const float RotationRate = FLSLocomotionRules::CalculateGroundedRotationRate(Curves, MappedSpeed, 0.f);
+				const FRotator Goal(0.f, Locomotion.Velocity.Rotation().Yaw, 0.f);
+				const FRotator Rotation = FLSLocomotionRules::SmoothRotation(Transform.Rotator(), Locomotion.TargetRotation, Goal, DeltaTime, 800.f, RotationRate);
+				Transform.SetRotation(Rotation.Quaternion());
+			}
+		}
+	});
+}
@@ -0,0 +1,29 @@
+// Copyright BanMing
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityQuery.h"
+#include "MassProcessor.h"
+
+#include "LSMassLocomotionProcessor.generated.h"
+
+/**
+ * Moves distant LS characters represented as Mass entities, with the gait and grounded rotation rules of ALSCharacterBase.
+ * There is no collision or floor here, the entities glide on their current height until they turn back into characters.
+ */
+UCLASS()
+class LOCOMOTIONSYSTEM_API ULSMassLocomotionProcessor : public UMassProcessor
+{
+	GENERATED_BODY()
+
+public:
+	ULSMassLocomotionProcessor();
+
+protected:
+	virtual void ConfigureQueries() override;
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+private:
+	FMassEntityQuery EntityQuery;
+};
@@ -0,0 +1,206 @@
+// Copyright BanMing
+
+#include "Subsystems/LSAvoidanceSubsystem.h"
+
+#include "Characters/LSCharacterBase.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+
+static TAutoConsoleVariable<int32> CVarAvoidanceEnabled(TEXT("LS.Avoidance.Enabled"), 1, TEXT("Steer registered AI characters around each other."));
+static TAutoConsoleVariable<float> CVarAvoidanceCellSize(TEXT("LS.Avoidance.CellSize"), 400.f, TEXT("Size of the spatial hash cells, which is also how far away neighbours are considered."));
+static TAutoConsoleVariable<float> CVarAvoidanceHorizon(TEXT("LS.Avoidance.Horizon"), 1.5f, TEXT("How many seconds ahead collisions are predicted."));
+static TAutoConsoleVariable<int32> CVarAvoidanceMaxNeighbors(TEXT("LS.Avoidance.MaxNeighbors"), 8, TEXT("Maximum number of neighbours each character avoids per frame."));
+
+bool ULSAvoidanceSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// AI only moves where it has authority.
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld() && World->GetNetMode() != NM_Client;
+}
+
+void ULSAvoidanceSubsystem::Deinitialize()
+{
+	Characters.Empty();
+	Agents.Empty();
+	CellHeads.Empty();
+	NextInCell.Empty();
+	Super::Deinitialize();
+}
+
+void ULSAvoidanceSubsystem::Tick(float DeltaTime)
+{
+	if (CVarAvoidanceEnabled.GetValueOnGameThread() == 0)
+	{
+		return;
+	}
+
+	GatherAgents();
+	if (Agents.Num() < 2)
+	{
+		return;
+	}
+
+	const float CellSize = FMath::Max(CVarAvoidanceCellSize.GetValueOnGameThread(), 50.f);
+	const float Horizon = FMath::Max(CVarAvoidanceHorizon.GetValueOnGameThread(), 0.1f);
+	const int32 MaxNeighbors = CVarAvoidanceMaxNeighbors.GetValueOnGameThread();
+	BuildSpatialHash(CellSize);
+
+	for (int32 Index = 0; Index < Agents.Num(); ++Index)
+	{
+		const FAgent& Agent = Agents[Index];
+		if (!Agent.bSteer)
+		{
+			continue;
+		}
+
+		const FVector2D Avoidance = CalculateAvoidance(Index, CellSize, Horizon, MaxNeighbors);
+		if (Avoidance.IsNearlyZero())
+		{
+			continue;
+		}
+
+		// In input units of the current gait, and never more than the input the character already has,
+		// so avoiding can slow a character down or turn it, but not push it into a faster gait.
+		FVector2D Steering = Avoidance * (Agent.Character->GetAvoidanceWeight() / Agent.MaxSpeed);
+		Steering = Steering.ClampAxes(-1.f, 1.f).GetClampedToMaxSize(Agent.InputAmount);
+
+		// Consumed together with the path following input by the next movement update.
+		Agent.Character->AddMovementInput(FVector(Steering, 0.f));
+	}
+}
+
+TStatId ULSAvoidanceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULSAvoidanceSubsystem, STATGROUP_Tickables);
+}
+
+void ULSAvoidanceSubsystem::RegisterCharacter(ALSCharacterBase* Character)
+{
+	if (IsValid(Character))
+	{
+		Characters.AddUnique(Character);
+	}
+}
+
+void ULSAvoidanceSubsystem::UnregisterCharacter(ALSCharacterBase* Character)
+{
+	Characters.RemoveSwap(Character);
+}
+
+void ULSAvoidanceSubsystem::GatherAgents()
+{
+	Characters.RemoveAllSwap([](const TWeakObjectPtr<ALSCharacterBase>& Character) { return !Character.IsValid(); });
+
+	Agents.Reset(Characters.Num());
+	for (const TWeakObjectPtr<ALSCharacterBase>& WeakCharacter : Characters)
+	{
+		ALSCharacterBase* Character = WeakCharacter.Get();
+		const UCharacterMovementComponent* MovementComp = Character->GetCharacterMovement();
+
+		// Pooled characters are hidden with their movement deactivated, they are not in the way of anyone.
+		if (Character->IsHidden() || MovementComp == nullptr || !MovementComp->IsActive())
+		{
+			continue;
+		}
+
+		FAgent& Agent = Agents.AddDefaulted_GetRef();
+		Agent.Character = Character;
+		Agent.Location = FVector2D(Character->GetActorLocation());
+		Agent.Velocity = FVector2D(Character->GetVelocity());
+		Agent.Radius = Character->GetCapsuleComponent()->GetScaledCapsuleRadius();
+
+		// The walk speed is set from the movement settings of the allowed gait.
+		Agent.MaxSpeed = MovementComp->GetMaxSpeed();
+		const float MaxAcceleration = MovementComp->GetMaxAcceleration();
+		Agent.InputAmount = MaxAcceleration > 0.f ? FMath::Min(MovementComp->GetCurrentAcceleration().Size() / MaxAcceleration, 1.f) : 0.f;
+		Agent.bSteer = Agent.MaxSpeed > 0.f && Agent.InputAmount > 0.f && Character->ShouldSteerForAvoidance();
+	}
+}
+
+void ULSAvoidanceSubsystem::BuildSpatialHash(float CellSize)
+{
+	CellHeads.Reset();
+	CellHeads.Reserve(Agents.Num());
+	NextInCell.SetNumUninitialized(Agents.Num());
+
+	for (int32 Index = 0; Index < Agents.Num(); ++Index)
+	{
+		int32& Head = CellHeads.FindOrAdd(GetCell(Agents[Index].Location, CellSize), INDEX_NONE);
+		NextInCell[Index] = Head;
+		Head = Index;
+	}
+}
+
+FVector2D ULSAvoidanceSubsystem::CalculateAvoidance(int32 AgentIndex, float CellSize, float Horizon, int32 MaxNeighbors) const
+{
+	const FAgent& Agent = Agents[AgentIndex];
+	const FIntPoint Cell = GetCell(Agent.Location, CellSize);
+	const float QueryRadiusSquared = FMath::Square(CellSize);
+
+	FVector2D Avoidance = FVector2D::ZeroVector;
+	int32 NumNeighbors = 0;
+
+	// Neighbours within a cell size are always in the 3x3 block of cells around the agent.
+	for (int32 OffsetY = -1; OffsetY <= 1; ++OffsetY)
+	{
+		for (int32 OffsetX = -1; OffsetX <= 1; ++OffsetX)
+		{
+			const int32* Head = CellHeads.Find(Cell + FIntPoint(OffsetX, OffsetY));
+			for (int32 Index = Head ? *Head : INDEX_NONE; Index != INDEX_NONE && NumNeighbors < MaxNeighbors; Index = NextInCell[Index])
+			{
+				if (Index == AgentIndex)
+				{
+					continue;
+				}
+
+				const FAgent& Other = Agents[Index];
+				const FVector2D RelativeLocation = Other.Location - Agent.Location;
+				const float DistanceSquared = RelativeLocation.SizeSquared();
+				if (DistanceSquared > QueryRadiusSquared)
+				{
+					continue;
+				}
+				++NumNeighbors;
+
+				// Already overlapping, push apart by how deep the capsules are in each other.
+				const float MinDistance = Agent.Radius + Other.Radius;
+				if (DistanceSquared < FMath::Square(MinDistance))
+				{
+					const float Distance = FMath::Sqrt(DistanceSquared);
+					const FVector2D Direction = Distance > UE_KINDA_SMALL_NUMBER ? RelativeLocation / Distance : FVector2D(-Agent.Velocity.Y, Agent.Velocity.X).GetSafeNormal();
+					Avoidance -= Direction * ((MinDistance - Distance) / MinDistance) * Agent.MaxSpeed;
+					continue;
+				}
+
+				// Time of closest approach, with both keeping their current velocity.
+				const FVector2D RelativeVelocity = Other.Velocity - Agent.Velocity;
+				const float RelativeSpeedSquared = RelativeVelocity.SizeSquared();
+				if (RelativeSpeedSquared < UE_KINDA_SMALL_NUMBER)
+				{
+					continue;
+				}
+
+				const float Time = -FVector2D::DotProduct(RelativeLocation, RelativeVelocity) / RelativeSpeedSquared;
+				if (Time <= 0.f || Time > Horizon)
+				{
+					continue;
+				}
+
+				const FVector2D ClosestOffset = RelativeLocation + RelativeVelocity * Time;
+				const float ClosestDistance = ClosestOffset.Size();
+				if (ClosestDistance >= MinDistance)
+				{
+					continue;
+				}
+
+				// Head on, pass to the side instead of braking.
+				const FVector2D Direction = ClosestDistance > UE_KINDA_SMALL_NUMBER ? ClosestOffset / ClosestDistance : FVector2D(-RelativeVelocity.Y, RelativeVelocity.X).GetSafeNormal();
+				const float Urgency = (1.f - Time / Horizon) * (1.f - ClosestDistance / MinDistance);
+				Avoidance -= Direction * Urgency * Agent.MaxSpeed;
+			}
+		}
+	}
+
+	return Avoidance;
+}
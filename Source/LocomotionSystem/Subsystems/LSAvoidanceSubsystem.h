@@ -0,0 +1,62 @@
+// Copyright BanMing
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "LSAvoidanceSubsystem.generated.h"
+
+class ALSCharacterBase;
+
+/**
+ * Crowd avoidance for AI driven LS characters. Registered characters are hashed into a 2D grid every frame,
+ * and each steered character only looks at the cells around it, so the cost grows with the number of characters, not its square.
+ * The steering is added as movement input, scaled by the speed of the current gait, so the gait speeds still cap how fast characters move.
+ */
+UCLASS()
+class LOCOMOTIONSYSTEM_API ULSAvoidanceSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	// Registered characters are avoided by the others, and steered themselves when ALSCharacterBase::ShouldSteerForAvoidance allows it.
+	void RegisterCharacter(ALSCharacterBase* Character);
+	void UnregisterCharacter(ALSCharacterBase* Character);
+
+private:
+	struct FAgent
+	{
+		ALSCharacterBase* Character = nullptr;
+		FVector2D Location = FVector2D::ZeroVector;
+		FVector2D Velocity = FVector2D::ZeroVector;
+		float Radius = 0.f;
+		float MaxSpeed = 0.f;
+		float InputAmount = 0.f;
+		bool bSteer = false;
+	};
+
+	void GatherAgents();
+	void BuildSpatialHash(float CellSize);
+
+	// Steering velocity that keeps the agent clear of its neighbours over the next Horizon seconds.
+	FVector2D CalculateAvoidance(int32 AgentIndex, float CellSize, float Horizon, int32 MaxNeighbors) const;
+
+	FIntPoint GetCell(const FVector2D& Location, float CellSize) const
+	{
+		return FIntPoint(FMath::FloorToInt32(Location.X / CellSize), FMath::FloorToInt32(Location.Y / CellSize));
+	}
+
+private:
+	TArray<TWeakObjectPtr<ALSCharacterBase>> Characters;
+
+	// Rebuilt every tick. Each cell points at its first agent, NextInCell links the agents sharing a cell.
+	TArray<FAgent> Agents;
+	TMap<FIntPoint, int32> CellHeads;
+	TArray<int32> NextInCell;
+};
@@ -0,0 +1,162 @@
+// Copyright BanMing
+
+#include "Subsystems/LSCharacterPoolSubsystem.h"
+
+#include "AIController.h"
+#include "BrainComponent.h"
+#include "Characters/LSCharacterBase.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+
+void ULSCharacterPoolSubsystem::Deinitialize()
+{
+	Pools.Empty();
+	Super::Deinitialize();
+}
+
+void ULSCharacterPoolSubsystem::Prewarm(TSubclassOf<ALSCharacterBase> CharacterClass, int32 Count)
+{
+	if (!CharacterClass)
+	{
+		return;
+	}
+
+	FLSCharacterPool& Pool = Pools.FindOrAdd(CharacterClass);
+	Pool.Available.Reserve(Pool.Available.Num() + Count);
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		if (ALSCharacterBase* Character = SpawnPooledCharacter(CharacterClass, FTransform::Identity))
+		{
+			SetCharacterActive(Character, false);
+			Pool.Available.Add(Character);
+		}
+	}
+}
+
+ALSCharacterBase* ULSCharacterPoolSubsystem::Acquire(TSubclassOf<ALSCharacterBase> CharacterClass, const FTransform& Transform)
+{
+	if (!CharacterClass)
+	{
+		return nullptr;
+	}
+
+	if (FLSCharacterPool* Pool = Pools.Find(CharacterClass))
+	{
+		while (Pool->Available.Num() > 0)
+		{
+			ALSCharacterBase* Character = Pool->Available.Pop(false);
+			if (!IsValid(Character))
+			{
+				continue;
+			}
+
+			ActivateCharacter(Character, Transform);
+			return Character;
+		}
+	}
+
+	// Pool exhausted, fall back to a regular spawn.
+	return SpawnPooledCharacter(CharacterClass, Transform);
+}
+
+void ULSCharacterPoolSubsystem::Release(ALSCharacterBase* Character)
+{
+	if (!IsValid(Character))
+	{
+		return;
+	}
+
+	// Releasing twice would hand the same character out to two callers.
+	FLSCharacterPool& Pool = Pools.FindOrAdd(Character->GetClass());
+	if (Pool.Available.Contains(Character))
+	{
+		return;
+	}
+
+	SetCharacterActive(Character, false);
+	Pool.Available.Add(Character);
+}
+
+void ULSCharacterPoolSubsystem::Park(ALSCharacterBase* Character)
+{
+	if (IsValid(Character))
+	{
+		SetCharacterActive(Character, false);
+	}
+}
+
+void ULSCharacterPoolSubsystem::Unpark(ALSCharacterBase* Character, const FTransform& Transform)
+{
+	if (IsValid(Character))
+	{
+		ActivateCharacter(Character, Transform);
+	}
+}
+
+int32 ULSCharacterPoolSubsystem::GetNumAvailable(TSubclassOf<ALSCharacterBase> CharacterClass) const
+{
+	const FLSCharacterPool* Pool = Pools.Find(CharacterClass);
+	return Pool ? Pool->Available.Num() : 0;
+}
+
+ALSCharacterBase* ULSCharacterPoolSubsystem::SpawnPooledCharacter(TSubclassOf<ALSCharacterBase> CharacterClass, const FTransform& Transform)
+{
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	return GetWorld()->SpawnActor<ALSCharacterBase>(CharacterClass, Transform, SpawnParams);
+}
+
+void ULSCharacterPoolSubsystem::ActivateCharacter(ALSCharacterBase* Character, const FTransform& Transform)
+{
+	Character->SetActorLocationAndRotation(Transform.GetLocation(), Transform.GetRotation(), false, nullptr, ETeleportType::ResetPhysics);
+	SetCharacterActive(Character, true);
+	Character->ResetLocomotionState();
+}
+
+void ULSCharacterPoolSubsystem::SetCharacterActive(ALSCharacterBase* Character, bool bActive)
+{
+	Character->SetActorHiddenInGame(!bActive);
+	Character->SetActorEnableCollision(bActive);
+	Character->SetActorTickEnabled(bActive);
+
+	if (UCharacterMovementComponent* MovementComp = Character->GetCharacterMovement())
+	{
+		if (bActive)
+		{
+			MovementComp->Activate(true);
+		}
+		else
+		{
+			MovementComp->StopMovementImmediately();
+			MovementComp->Deactivate();
+		}
+	}
+
+	if (USkeletalMeshComponent* Mesh = Character->GetMesh())
+	{
+		Mesh->SetComponentTickEnabled(bActive);
+	}
+
+	// The controller stays possessed, it would otherwise keep thinking and pathing for a hidden pawn.
+	if (AAIController* AIController = Cast<AAIController>(Character->GetController()))
+	{
+		UBrainComponent* Brain = AIController->GetBrainComponent();
+		if (bActive)
+		{
+			if (Brain)
+			{
+				Brain->ResumeLogic(TEXT("LSCharacterPool"));
+			}
+		}
+		else
+		{
+			AIController->StopMovement();
+			if (Brain)
+			{
+				Brain->PauseLogic(TEXT("LSCharacterPool"));
+			}
+		}
+		AIController->SetActorTickEnabled(bActive);
+	}
+}
@@ -0,0 +1,62 @@
+// Copyright BanMing
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "LSCharacterPoolSubsystem.generated.h"
+
+class ALSCharacterBase;
+
+USTRUCT()
+struct FLSCharacterPool
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<TObjectPtr<ALSCharacterBase>> Available;
+};
+
+/**
+ * Pre-spawns LS characters and hands them out on demand,
+ * so waves of spawns only pay for a teleport and a locomotion state reset instead of actor construction and BeginPlay.
+ * Pooled characters are inert: besides the character's own ticks and collision, an AI controller keeps possessing it
+ * but has its movement stopped, its brain paused and its tick disabled until the character is acquired again.
+ */
+UCLASS()
+class LOCOMOTIONSYSTEM_API ULSCharacterPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// Spawn characters of the class up front and park them hidden and deactivated in the pool.
+	void Prewarm(TSubclassOf<ALSCharacterBase> CharacterClass, int32 Count);
+
+	// Take a character out of the pool, or spawn one if the pool is empty.
+	ALSCharacterBase* Acquire(TSubclassOf<ALSCharacterBase> CharacterClass, const FTransform& Transform);
+
+	// Hide and deactivate the character, pause its AI and return it to the pool of its class.
+	void Release(ALSCharacterBase* Character);
+
+	// Hide and deactivate the character like a released one, without handing it out to Acquire.
+	// For owners that bring back this very actor later with Unpark.
+	void Park(ALSCharacterBase* Character);
+	void Unpark(ALSCharacterBase* Character, const FTransform& Transform);
+
+	int32 GetNumAvailable(TSubclassOf<ALSCharacterBase> CharacterClass) const;
+
+private:
+	ALSCharacterBase* SpawnPooledCharacter(TSubclassOf<ALSCharacterBase> CharacterClass, const FTransform& Transform);
+
+	// Teleport, reactivate and reset a pooled or parked character.
+	static void ActivateCharacter(ALSCharacterBase* Character, const FTransform& Transform);
+
+	static void SetCharacterActive(ALSCharacterBase* Character, bool bActive);
+
+private:
+	UPROPERTY()
+	TMap<TSubclassOf<ALSCharacterBase>, FLSCharacterPool> Pools;
+};
@@ -0,0 +1,228 @@
+// Copyright BanMing
+
+#include "Subsystems/LSClimbingIKSubsystem.h"
+
+#include "Characters/LSCharacterBase.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/LSCharacterMovementComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+
+static constexpr int32 NumClimbingLimbs = static_cast<int32>(ELSClimbingLimb::MAX);
+
+bool ULSClimbingIKSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// Limb placement is purely visual.
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld() && World->GetNetMode() != NM_DedicatedServer;
+}
+
+void ULSClimbingIKSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	TraceScheduler = Collection.InitializeDependency<ULSTraceSchedulerSubsystem>();
+}
+
+void ULSClimbingIKSubsystem::Deinitialize()
+{
+	Climbers.Empty();
+	TraceScheduler = nullptr;
+	Super::Deinitialize();
+}
+
+void ULSClimbingIKSubsystem::Tick(float DeltaTime)
+{
+	for (int32 Index = Climbers.Num() - 1; Index >= 0; --Index)
+	{
+		const ALSCharacterBase* Character = Climbers[Index].Character.Get();
+		if (!IsValid(Character))
+		{
+			Climbers.RemoveAtSwap(Index);
+			continue;
+		}
+
+		UpdateClimber(Climbers[Index], *Character);
+	}
+}
+
+TStatId ULSClimbingIKSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULSClimbingIKSubsystem, STATGROUP_Tickables);
+}
+
+void ULSClimbingIKSubsystem::RegisterClimber(ALSCharacterBase* Character)
+{
+	if (IsValid(Character) && FindLimbTargets(Character) == nullptr)
+	{
+		Climbers.AddDefaulted_GetRef().Character = Character;
+	}
+}
+
+void ULSClimbingIKSubsystem::UnregisterClimber(ALSCharacterBase* Character)
+{
+	Climbers.RemoveAllSwap([this, Character](FClimber& Climber) {
+		if (Climber.Character.Get() != Character)
+		{
+			return false;
+		}
+
+		// Free the budget of the probes still queued.
+		if (TraceScheduler)
+		{
+			for (FLSTraceTicket& Ticket : Climber.PendingTraces)
+			{
+				TraceScheduler->CancelTrace(Ticket);
+			}
+			TraceScheduler->CancelTrace(Climber.ProxySurfaceTrace);
+		}
+		return true;
+	});
+}
+
+const FLSClimbingLimbTargets* ULSClimbingIKSubsystem::FindLimbTargets(const ALSCharacterBase* Character) const
+{
+	const FClimber* Climber = Climbers.FindByPredicate([Character](const FClimber& Entry) { return Entry.Character.Get() == Character; });
+	return Climber ? &Climber->Targets : nullptr;
+}
+
+void ULSClimbingIKSubsystem::UpdateClimber(FClimber& Climber, const ALSCharacterBase& Character)
+{
+	const ULSCharacterMovementComponent* MovementComp = Character.GetLSMovementComponent();
+	FVector SurfacePoint;
+	FVector SurfaceNormal;
+	bool bHasSurface = false;
+	if (MovementComp)
+	{
+		bHasSurface = Character.GetLocalRole() == ROLE_SimulatedProxy ? MovementComp->IsClimbing() && UpdateProxySurface(Climber, Character, SurfacePoint, SurfaceNormal)
+																	  : MovementComp->GetClimbSurface(SurfacePoint, SurfaceNormal);
+	}
+
+	if (!bHasSurface)
+	{
+		for (FLSClimbingLimbTarget& Target : Climber.Targets.Limbs)
+		{
+			Target.Alpha = 0.f;
+		}
+		return;
+	}
+
+	const FLSClimbingIKSettings& Settings = Character.GetClimbingIKSettings();
+	// The same directions the movement component climbs along.
+	const FVector Up = FVector::VectorPlaneProject(FVector::UpVector, SurfaceNormal).GetSafeNormal();
+	const FVector Right = FVector::CrossProduct(Up, -SurfaceNormal).GetSafeNormal();
+	const FVector PredictedCenter = Character.GetActorLocation() + MovementComp->Velocity * Settings.PredictionTime;
+	const bool bStationary = MovementComp->Velocity.IsNearlyZero();
+
+	const USkeletalMeshComponent* Mesh = Character.GetMesh();
+	const bool bTrace = Mesh && Mesh->GetPredictedLODLevel() <= Settings.MaxTraceLOD;
+
+	const ELSTracePriority Priority = TraceScheduler ? TraceScheduler->GetPriority(&Character) : ELSTracePriority::DistantAI;
+	const double Deadline = GetWorld()->GetTimeSeconds() + Settings.PredictionTime;
+	for (int32 LimbIndex = 0; LimbIndex < NumClimbingLimbs; ++LimbIndex)
+	{
+		const FVector2D& Offset = Settings.GetLimbOffset(static_cast<ELSClimbingLimb>(LimbIndex));
+		const FVector ProbeStart = PredictedCenter + Right * Offset.X + Up * Offset.Y + SurfaceNormal * Settings.ProbeStartDistance;
+		FLSClimbingLimbTarget& Target = Climber.Targets.Limbs[LimbIndex];
+
+		if (!bTrace || TraceScheduler == nullptr)
+		{
+			// Analytic fallback, good enough at a distance.
+			Target.Location = FVector::PointPlaneProject(ProbeStart, SurfacePoint, SurfaceNormal);
+			Target.Normal = SurfaceNormal;
+			Target.Alpha = 1.f;
+			continue;
+		}
+
+		// A limb holding still keeps its grip, and only one probe per limb is pending.
+		if ((bStationary && Target.Alpha > 0.f) || TraceScheduler->IsPending(Climber.PendingTraces[LimbIndex]))
+		{
+			continue;
+		}
+
+		// Probes are only useful until the capsule reached the predicted position.
+		FLSTraceRequest Request;
+		Request.Start = ProbeStart;
+		Request.End = ProbeStart - SurfaceNormal * Settings.ProbeDepth;
+		Request.Channel = Settings.TraceChannel;
+		Request.Params = FCollisionQueryParams(SCENE_QUERY_STAT(ClimbingLimbIK), false, &Character);
+		Request.Priority = Priority;
+		Request.Deadline = Deadline;
+		Request.OnCompleted.BindUObject(this, &ULSClimbingIKSubsystem::OnLimbTraceCompleted, LimbIndex);
+		Climber.PendingTraces[LimbIndex] = TraceScheduler->RequestTrace(MoveTemp(Request));
+	}
+}
+
+bool ULSClimbingIKSubsystem::UpdateProxySurface(FClimber& Climber, const ALSCharacterBase& Character, FVector& OutPoint, FVector& OutNormal)
+{
+	// The replicated capsule faces the surface while climbing, one trace along it finds the surface again.
+	// Goes through the scheduler like the limb probes, the cached plane is used until the result arrives.
+	const FLSClimbingIKSettings& Settings = Character.GetClimbingIKSettings();
+	const FVector Location = Character.GetActorLocation();
+	const bool bReprobe = !Climber.bProxySurfaceValid || FVector::DistSquared(Location, Climber.ProxyProbeLocation) >= FMath::Square(Settings.ProxySurfaceReuseDistance);
+	if (bReprobe && TraceScheduler && !TraceScheduler->IsPending(Climber.ProxySurfaceTrace))
+	{
+		FLSTraceRequest Request;
+		Request.Start = Location;
+		Request.End = Location + Character.GetActorForwardVector() * (Character.GetCapsuleComponent()->GetScaledCapsuleRadius() + Settings.ProbeDepth);
+		Request.Channel = Settings.TraceChannel;
+		Request.Params = FCollisionQueryParams(SCENE_QUERY_STAT(ClimbingProxySurface), false, &Character);
+		Request.Priority = TraceScheduler->GetPriority(&Character);
+		Request.Deadline = GetWorld()->GetTimeSeconds() + Settings.PredictionTime;
+		Request.OnCompleted.BindUObject(this, &ULSClimbingIKSubsystem::OnProxySurfaceTraceCompleted);
+		Climber.PendingProxyProbeLocation = Location;
+		Climber.ProxySurfaceTrace = TraceScheduler->RequestTrace(MoveTemp(Request));
+	}
+
+	OutPoint = Climber.ProxySurfacePoint;
+	OutNormal = Climber.ProxySurfaceNormal;
+	return Climber.bProxySurfaceValid;
+}
+
+void ULSClimbingIKSubsystem::OnProxySurfaceTraceCompleted(FLSTraceTicket Ticket, const FLSTraceResult& Result)
+{
+	FClimber* Climber = Climbers.FindByPredicate([&Ticket](const FClimber& Entry) { return Entry.ProxySurfaceTrace == Ticket; });
+	if (Climber == nullptr)
+	{
+		return;
+	}
+	Climber->ProxySurfaceTrace.Reset();
+
+	// An expired probe keeps the cached plane and is requested again next frame.
+	if (Result.Status == ELSTraceStatus::Expired)
+	{
+		return;
+	}
+
+	Climber->bProxySurfaceValid = Result.Status == ELSTraceStatus::Hit;
+	Climber->ProxySurfacePoint = Result.Hit.ImpactPoint;
+	Climber->ProxySurfaceNormal = Result.Hit.ImpactNormal;
+	Climber->ProxyProbeLocation = Climber->PendingProxyProbeLocation;
+}
+
+void ULSClimbingIKSubsystem::OnLimbTraceCompleted(FLSTraceTicket Ticket, const FLSTraceResult& Result, int32 LimbIndex)
+{
+	FClimber* Climber = Climbers.FindByPredicate([&Ticket, LimbIndex](const FClimber& Entry) { return Entry.PendingTraces[LimbIndex] == Ticket; });
+	if (Climber == nullptr)
+	{
+		return;
+	}
+	Climber->PendingTraces[LimbIndex].Reset();
+
+	// An expired probe keeps the current grip and is requested again next frame.
+	if (Result.Status == ELSTraceStatus::Expired)
+	{
+		return;
+	}
+
+	FLSClimbingLimbTarget& Target = Climber->Targets.Limbs[LimbIndex];
+	if (Result.Status != ELSTraceStatus::Hit)
+	{
+		// Nothing to hold on to, the limb blends out.
+		Target.Alpha = 0.f;
+		return;
+	}
+
+	Target.Location = Result.Hit.ImpactPoint;
+	Target.Normal = Result.Hit.ImpactNormal;
+	Target.Alpha = 1.f;
+}
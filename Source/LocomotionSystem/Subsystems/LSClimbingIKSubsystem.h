@@ -0,0 +1,66 @@
+// Copyright BanMing
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/ClimbingIKSettings.h"
+#include "Subsystems/LSTraceSchedulerSubsystem.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "LSClimbingIKSubsystem.generated.h"
+
+class ALSCharacterBase;
+
+/**
+ * Places the hands and feet of every climbing character on the climbed surface.
+ * All limb probes of all climbers go out as one batch through the trace scheduler, placed ahead along the climb velocity,
+ * and distant characters skip the traces and project onto the surface plane instead.
+ */
+UCLASS()
+class LOCOMOTIONSYSTEM_API ULSClimbingIKSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	void RegisterClimber(ALSCharacterBase* Character);
+	void UnregisterClimber(ALSCharacterBase* Character);
+
+	// Latest limb targets of the character, null if it is not climbing.
+	const FLSClimbingLimbTargets* FindLimbTargets(const ALSCharacterBase* Character) const;
+
+private:
+	struct FClimber
+	{
+		TWeakObjectPtr<ALSCharacterBase> Character;
+		FLSClimbingLimbTargets Targets;
+		FLSTraceTicket PendingTraces[static_cast<int32>(ELSClimbingLimb::MAX)];
+
+		// Surface found for a simulated proxy, and where it was looked for from.
+		FVector ProxySurfacePoint = FVector::ZeroVector;
+		FVector ProxySurfaceNormal = FVector::ZeroVector;
+		FVector ProxyProbeLocation = FVector::ZeroVector;
+		bool bProxySurfaceValid = false;
+
+		FLSTraceTicket ProxySurfaceTrace;
+		FVector PendingProxyProbeLocation = FVector::ZeroVector;
+	};
+
+	void UpdateClimber(FClimber& Climber, const ALSCharacterBase& Character);
+
+	// Simulated proxies never run the climbing move, so they have no surface of their own.
+	bool UpdateProxySurface(FClimber& Climber, const ALSCharacterBase& Character, FVector& OutPoint, FVector& OutNormal);
+	void OnLimbTraceCompleted(FLSTraceTicket Ticket, const FLSTraceResult& Result, int32 LimbIndex);
+	void OnProxySurfaceTraceCompleted(FLSTraceTicket Ticket, const FLSTraceResult& Result);
+
+private:
+	TArray<FClimber> Climbers;
+
+	UPROPERTY(Transient)
+	TObjectPtr<ULSTraceSchedulerSubsystem> TraceScheduler;
+};
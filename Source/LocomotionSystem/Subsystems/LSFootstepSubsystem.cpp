@@ -0,0 +1,209 @@
+// Copyright BanMing
+
+#include "Subsystems/LSFootstepSubsystem.h"
+
+#include "Camera/PlayerCameraManager.h"
+#include "Components/AudioComponent.h"
+#include "Components/DecalComponent.h"
+#include "Data/FootstepSurfaceTable.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+
+static TAutoConsoleVariable<int32> CVarFootstepMaxPerFrame(TEXT("LS.Footsteps.MaxPerFrame"), 8, TEXT("Maximum number of footsteps played per frame, the rest are dropped."));
+static TAutoConsoleVariable<float> CVarFootstepCullDistance(TEXT("LS.Footsteps.CullDistance"), 2500.f, TEXT("Footsteps further than this from every local camera are dropped."));
+static TAutoConsoleVariable<int32> CVarFootstepAudioPoolSize(TEXT("LS.Footsteps.AudioPoolSize"), 24, TEXT("Number of pooled footstep audio components."));
+static TAutoConsoleVariable<int32> CVarFootstepDecalPoolSize(TEXT("LS.Footsteps.DecalPoolSize"), 48, TEXT("Number of pooled footstep decal components."));
+
+bool ULSFootstepSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// Nothing to hear or see on a dedicated server.
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld() && World->GetNetMode() != NM_DedicatedServer;
+}
+
+void ULSFootstepSubsystem::Deinitialize()
+{
+	AudioPool.Empty();
+	DecalPool.Empty();
+	DecalExpireTimes.Empty();
+	PoolOwner = nullptr;
+
+	Super::Deinitialize();
+}
+
+void ULSFootstepSubsystem::Tick(float DeltaTime)
+{
+	// Hide decals whose life span has run out, they stay registered for reuse.
+	const double Now = GetWorld()->GetTimeSeconds();
+	for (int32 Index = 0; Index < DecalPool.Num(); ++Index)
+	{
+		if (DecalExpireTimes[Index] > 0.0 && DecalExpireTimes[Index] <= Now)
+		{
+			DecalPool[Index]->SetVisibility(false);
+			DecalExpireTimes[Index] = 0.0;
+		}
+	}
+}
+
+TStatId ULSFootstepSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULSFootstepSubsystem, STATGROUP_Tickables);
+}
+
+bool ULSFootstepSubsystem::PlayFootstep(const FLSFootstepRequest& Request)
+{
+	if (Request.SurfaceTable == nullptr || (!Request.bPlaySound && !Request.bSpawnDecal))
+	{
+		return false;
+	}
+
+	// Per-frame cap and distance culling come first, so culled footsteps cost neither a trace nor a component.
+	if (BudgetFrame != GFrameCounter)
+	{
+		BudgetFrame = GFrameCounter;
+		FootstepsThisFrame = 0;
+	}
+	if (FootstepsThisFrame >= CVarFootstepMaxPerFrame.GetValueOnGameThread() || !IsWithinCullDistance(Request.FootLocation))
+	{
+		return false;
+	}
+	++FootstepsThisFrame;
+
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(FootstepTrace), false, Request.Instigator);
+	Params.bReturnPhysicalMaterial = true;
+
+	FHitResult Hit;
+	const FVector TraceStart = Request.FootLocation + FVector(0.f, 0.f, 20.f);
+	const FVector TraceEnd = Request.FootLocation - FVector(0.f, 0.f, 30.f);
+	if (!GetWorld()->LineTraceSingleByChannel(Hit, TraceStart, TraceEnd, ECC_Visibility, Params))
+	{
+		return false;
+	}
+
+	EnsurePools();
+
+	const FLSFootstepSurface& Surface = Request.SurfaceTable->GetSurface(UPhysicalMaterial::DetermineSurfaceType(Hit.PhysMaterial.Get()));
+	if (Request.bPlaySound && Surface.Sound)
+	{
+		if (UAudioComponent* AudioComp = GetFreeAudioComponent())
+		{
+			AudioComp->SetWorldLocation(Hit.ImpactPoint);
+			AudioComp->SetSound(Surface.Sound);
+			AudioComp->SetVolumeMultiplier(Request.VolumeMultiplier);
+			AudioComp->SetPitchMultiplier(Request.PitchMultiplier);
+			AudioComp->SetIntParameter(TEXT("FootstepType"), Request.FootstepType);
+			AudioComp->Play();
+		}
+	}
+
+	if (Request.bSpawnDecal && Surface.DecalMaterial)
+	{
+		const int32 DecalIndex = AcquireDecalIndex();
+		if (DecalIndex != INDEX_NONE)
+		{
+			UDecalComponent* DecalComp = DecalPool[DecalIndex];
+			// Project into the surface, with the decal pointing the way the character faces.
+			const FVector Forward = Request.Instigator ? Request.Instigator->GetActorForwardVector() : FVector::ForwardVector;
+			const FRotator DecalRotation = FRotationMatrix::MakeFromXZ(-Hit.ImpactNormal, Forward).Rotator();
+			DecalComp->SetWorldLocationAndRotation(Hit.ImpactPoint, DecalRotation);
+			DecalComp->SetDecalMaterial(Surface.DecalMaterial);
+			DecalComp->DecalSize = Surface.DecalSize;
+			DecalComp->SetVisibility(true);
+			DecalComp->MarkRenderStateDirty();
+			DecalExpireTimes[DecalIndex] = GetWorld()->GetTimeSeconds() + Surface.DecalLifeSpan;
+		}
+	}
+
+	return true;
+}
+
+bool ULSFootstepSubsystem::IsWithinCullDistance(const FVector& Location) const
+{
+	const float CullDistanceSquared = FMath::Square(CVarFootstepCullDistance.GetValueOnGameThread());
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		if (PlayerController && PlayerController->IsLocalController() && PlayerController->PlayerCameraManager)
+		{
+			if (FVector::DistSquared(PlayerController->PlayerCameraManager->GetCameraLocation(), Location) <= CullDistanceSquared)
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+void ULSFootstepSubsystem::EnsurePools()
+{
+	if (IsValid(PoolOwner))
+	{
+		return;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.ObjectFlags |= RF_Transient;
+	PoolOwner = GetWorld()->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParams);
+
+	const int32 AudioPoolSize = CVarFootstepAudioPoolSize.GetValueOnGameThread();
+	AudioPool.Reset(AudioPoolSize);
+	for (int32 Index = 0; Index < AudioPoolSize; ++Index)
+	{
+		UAudioComponent* AudioComp = NewObject<UAudioComponent>(PoolOwner);
+		AudioComp->bAutoActivate = false;
+		AudioComp->bAutoDestroy = false;
+		AudioComp->SetUsingAbsoluteLocation(true);
+		AudioComp->RegisterComponent();
+		AudioPool.Add(AudioComp);
+	}
+
+	const int32 DecalPoolSize = CVarFootstepDecalPoolSize.GetValueOnGameThread();
+	DecalPool.Reset(DecalPoolSize);
+	DecalExpireTimes.Init(0.0, DecalPoolSize);
+	for (int32 Index = 0; Index < DecalPoolSize; ++Index)
+	{
+		UDecalComponent* DecalComp = NewObject<UDecalComponent>(PoolOwner);
+		DecalComp->SetUsingAbsoluteLocation(true);
+		DecalComp->SetUsingAbsoluteRotation(true);
+		DecalComp->SetVisibility(false);
+		DecalComp->RegisterComponent();
+		DecalPool.Add(DecalComp);
+	}
+}
+
+UAudioComponent* ULSFootstepSubsystem::GetFreeAudioComponent()
+{
+	// Prefer an idle component, otherwise steal the one that started playing the longest ago.
+	for (int32 Count = 0; Count < AudioPool.Num(); ++Count)
+	{
+		UAudioComponent* AudioComp = AudioPool[NextAudioIndex];
+		NextAudioIndex = (NextAudioIndex + 1) % AudioPool.Num();
+		if (!AudioComp->IsPlaying())
+		{
+			return AudioComp;
+		}
+	}
+
+	UAudioComponent* Oldest = AudioPool.Num() > 0 ? AudioPool[NextAudioIndex].Get() : nullptr;
+	if (Oldest)
+	{
+		Oldest->Stop();
+		NextAudioIndex = (NextAudioIndex + 1) % AudioPool.Num();
+	}
+	return Oldest;
+}
+
+int32 ULSFootstepSubsystem::AcquireDecalIndex()
+{
+	// Ring buffer, the oldest decal is reused first.
+	if (DecalPool.Num() == 0)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 DecalIndex = NextDecalIndex;
+	NextDecalIndex = (NextDecalIndex + 1) % DecalPool.Num();
+	return DecalIndex;
+}
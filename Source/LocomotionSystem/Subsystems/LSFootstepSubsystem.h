@@ -0,0 +1,67 @@
+// Copyright BanMing
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "LSFootstepSubsystem.generated.h"
+
+class UAudioComponent;
+class UDecalComponent;
+class ULSFootstepSurfaceTable;
+
+struct FLSFootstepRequest
+{
+	const ULSFootstepSurfaceTable* SurfaceTable = nullptr;
+	const AActor* Instigator = nullptr;
+	FVector FootLocation = FVector::ZeroVector;
+	int32 FootstepType = 0;
+	float VolumeMultiplier = 1.f;
+	float PitchMultiplier = 1.f;
+	bool bPlaySound = true;
+	bool bSpawnDecal = false;
+};
+
+/**
+ * Plays footstep sounds and decals from fixed pools of components instead of spawning new ones per step.
+ * Footsteps are distance culled against the local cameras and capped per frame before any trace or spawn.
+ */
+UCLASS()
+class LOCOMOTIONSYSTEM_API ULSFootstepSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	// Returns false if the footstep was culled.
+	bool PlayFootstep(const FLSFootstepRequest& Request);
+
+private:
+	bool IsWithinCullDistance(const FVector& Location) const;
+	void EnsurePools();
+	UAudioComponent* GetFreeAudioComponent();
+	int32 AcquireDecalIndex();
+
+private:
+	UPROPERTY(Transient)
+	TObjectPtr<AActor> PoolOwner;
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UAudioComponent>> AudioPool;
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UDecalComponent>> DecalPool;
+
+	// World time at which each pooled decal is hidden again.
+	TArray<double> DecalExpireTimes;
+	int32 NextDecalIndex = 0;
+	int32 NextAudioIndex = 0;
+
+	uint64 BudgetFrame = 0;
+	int32 FootstepsThisFrame = 0;
+};
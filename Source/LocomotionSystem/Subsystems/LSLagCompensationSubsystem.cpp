@@ -0,0 +1,229 @@
+// Copyright BanMing
+
+#include "Subsystems/LSLagCompensationSubsystem.h"
+
+#include "Characters/LSCharacterBase.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "LocomotionSystem.h"
+
+static TAutoConsoleVariable<int32> CVarLagCompensationMaxCharacters(TEXT("LS.LagCompensation.MaxCharacters"), 256, TEXT("Characters the transform history is allocated for, read when the world starts."));
+static TAutoConsoleVariable<int32> CVarLagCompensationHistoryLength(TEXT("LS.LagCompensation.HistoryLength"), 64, TEXT("Server ticks of transform history kept per character, read when the world starts."));
+
+bool ULSLagCompensationSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// Only a server validates hits.
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld() && (World->GetNetMode() == NM_DedicatedServer || World->GetNetMode() == NM_ListenServer);
+}
+
+void ULSLagCompensationSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	HistoryLength = FMath::Max(CVarLagCompensationHistoryLength.GetValueOnGameThread(), 2);
+	const int32 MaxCharacters = FMath::Max(CVarLagCompensationMaxCharacters.GetValueOnGameThread(), 1);
+
+	Samples.SetNum(MaxCharacters * HistoryLength);
+	FrameTimes.SetNumZeroed(HistoryLength);
+	Slots.SetNum(MaxCharacters);
+	SlotIndices.Reserve(MaxCharacters);
+
+	// Popped from the back, so slots are handed out from 0 up.
+	FreeSlots.Reserve(MaxCharacters);
+	for (int32 Slot = MaxCharacters - 1; Slot >= 0; --Slot)
+	{
+		FreeSlots.Add(Slot);
+	}
+}
+
+void ULSLagCompensationSubsystem::Deinitialize()
+{
+	Samples.Empty();
+	FrameTimes.Empty();
+	Slots.Empty();
+	FreeSlots.Empty();
+	SlotIndices.Empty();
+	Super::Deinitialize();
+}
+
+void ULSLagCompensationSubsystem::Tick(float DeltaTime)
+{
+	NewestFrame = (NewestFrame + 1) % HistoryLength;
+	NumFrames = FMath::Min(NumFrames + 1, HistoryLength);
+	FrameTimes[NewestFrame] = GetWorld()->GetTimeSeconds();
+
+	for (int32 Slot = 0; Slot < Slots.Num(); ++Slot)
+	{
+		FSample& Sample = Samples[Slot * HistoryLength + NewestFrame];
+		const ALSCharacterBase* Character = Slots[Slot].Character.Get();
+
+		// Pooled characters are hidden and cannot be hit.
+		if (Character == nullptr || Character->IsHidden())
+		{
+			Sample.bValid = false;
+			continue;
+		}
+
+		const UCapsuleComponent* Capsule = Character->GetCapsuleComponent();
+		const FVector Location = Capsule->GetComponentLocation() * LocationScale;
+		Sample.Location = FIntVector(FMath::RoundToInt32(Location.X), FMath::RoundToInt32(Location.Y), FMath::RoundToInt32(Location.Z));
+		Sample.Yaw = FRotator::CompressAxisToShort(Capsule->GetComponentRotation().Yaw);
+		Sample.HalfHeight = static_cast<uint16>(FMath::Clamp(FMath::RoundToInt32(Capsule->GetScaledCapsuleHalfHeight() * HalfHeightScale), 0, MAX_uint16));
+		Sample.MovementState = static_cast<uint8>(Character->GetMovementState());
+		Sample.bValid = true;
+	}
+}
+
+TStatId ULSLagCompensationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULSLagCompensationSubsystem, STATGROUP_Tickables);
+}
+
+void ULSLagCompensationSubsystem::RegisterCharacter(ALSCharacterBase* Character)
+{
+	if (!IsValid(Character) || SlotIndices.Contains(Character))
+	{
+		return;
+	}
+
+	if (FreeSlots.Num() == 0)
+	{
+		UE_LOG(LogLocomotion, Warning, TEXT("No transform history left for '%s', raise LS.LagCompensation.MaxCharacters."), *Character->GetName());
+		return;
+	}
+
+	const int32 Slot = FreeSlots.Pop(false);
+	Slots[Slot].Character = Character;
+	Slots[Slot].Radius = Character->GetCapsuleComponent()->GetScaledCapsuleRadius();
+	SlotIndices.Add(Character, Slot);
+
+	// Whatever the previous owner left is not this character's history.
+	for (int32 FrameIndex = 0; FrameIndex < HistoryLength; ++FrameIndex)
+	{
+		Samples[Slot * HistoryLength + FrameIndex].bValid = false;
+	}
+}
+
+void ULSLagCompensationSubsystem::UnregisterCharacter(ALSCharacterBase* Character)
+{
+	int32 Slot = INDEX_NONE;
+	if (SlotIndices.RemoveAndCopyValue(Character, Slot))
+	{
+		Slots[Slot] = FSlot();
+		FreeSlots.Add(Slot);
+	}
+}
+
+bool ULSLagCompensationSubsystem::RewindCharacter(const ALSCharacterBase* Character, double Time, FLSRewoundCapsule& OutCapsule) const
+{
+	const int32* Slot = SlotIndices.Find(Character);
+	int32 NewerAge;
+	int32 OlderAge;
+	float Alpha;
+	return Slot && FindFrames(Time, NewerAge, OlderAge, Alpha) && RewindSlot(*Slot, NewerAge, OlderAge, Alpha, OutCapsule);
+}
+
+int32 ULSLagCompensationSubsystem::RewindRegion(double Time, const FVector& Center, float Radius, TArray<FLSRewoundCapsule>& OutCapsules) const
+{
+	int32 NewerAge;
+	int32 OlderAge;
+	float Alpha;
+	if (!FindFrames(Time, NewerAge, OlderAge, Alpha))
+	{
+		return 0;
+	}
+
+	const int32 NumBefore = OutCapsules.Num();
+	for (const TPair<TObjectKey<ALSCharacterBase>, int32>& Pair : SlotIndices)
+	{
+		FLSRewoundCapsule Capsule;
+		if (!RewindSlot(Pair.Value, NewerAge, OlderAge, Alpha, Capsule))
+		{
+			continue;
+		}
+
+		// Closest point of the upright capsule's segment to the center.
+		const FVector SegmentOffset(0.f, 0.f, FMath::Max(Capsule.HalfHeight - Capsule.Radius, 0.f));
+		const FVector Closest = FMath::ClosestPointOnSegment(Center, Capsule.Location - SegmentOffset, Capsule.Location + SegmentOffset);
+		if (FVector::DistSquared(Closest, Center) <= FMath::Square(Radius + Capsule.Radius))
+		{
+			OutCapsules.Add(Capsule);
+		}
+	}
+
+	return OutCapsules.Num() - NumBefore;
+}
+
+double ULSLagCompensationSubsystem::GetOldestTime() const
+{
+	return NumFrames > 0 ? FrameTimes[GetFrameIndex(NumFrames - 1)] : 0.0;
+}
+
+double ULSLagCompensationSubsystem::GetNewestTime() const
+{
+	return NumFrames > 0 ? FrameTimes[NewestFrame] : 0.0;
+}
+
+bool ULSLagCompensationSubsystem::FindFrames(double Time, int32& OutNewerAge, int32& OutOlderAge, float& OutAlpha) const
+{
+	if (NumFrames == 0 || Time < GetOldestTime())
+	{
+		return false;
+	}
+
+	// Newer than the last tick, nothing happened since.
+	if (Time >= GetNewestTime())
+	{
+		OutNewerAge = 0;
+		OutOlderAge = 0;
+		OutAlpha = 0.f;
+		return true;
+	}
+
+	// Frame times only grow with the age going down, binary search for the first frame at or before the time.
+	int32 Low = 1;
+	int32 High = NumFrames - 1;
+	while (Low < High)
+	{
+		const int32 Mid = (Low + High) / 2;
+		if (FrameTimes[GetFrameIndex(Mid)] <= Time)
+		{
+			High = Mid;
+		}
+		else
+		{
+			Low = Mid + 1;
+		}
+	}
+
+	OutOlderAge = Low;
+	OutNewerAge = Low - 1;
+	const double OlderTime = FrameTimes[GetFrameIndex(OutOlderAge)];
+	const double NewerTime = FrameTimes[GetFrameIndex(OutNewerAge)];
+	OutAlpha = NewerTime > OlderTime ? static_cast<float>((Time - OlderTime) / (NewerTime - OlderTime)) : 1.f;
+	return true;
+}
+
+bool ULSLagCompensationSubsystem::RewindSlot(int32 Slot, int32 NewerAge, int32 OlderAge, float Alpha, FLSRewoundCapsule& OutCapsule) const
+{
+	const FSample& Newer = GetSample(Slot, GetFrameIndex(NewerAge));
+	const FSample& Older = GetSample(Slot, GetFrameIndex(OlderAge));
+	if (!Newer.bValid || !Older.bValid)
+	{
+		return false;
+	}
+
+	const float OlderYaw = FRotator::DecompressAxisFromShort(Older.Yaw);
+	const float NewerYaw = FRotator::DecompressAxisFromShort(Newer.Yaw);
+
+	OutCapsule.Character = Slots[Slot].Character.Get();
+	OutCapsule.Location = FMath::Lerp(FVector(Older.Location), FVector(Newer.Location), static_cast<double>(Alpha)) / LocationScale;
+	OutCapsule.Rotation = FRotator(0.f, OlderYaw + FRotator::NormalizeAxis(NewerYaw - OlderYaw) * Alpha, 0.f);
+	OutCapsule.HalfHeight = FMath::Lerp<float>(Older.HalfHeight, Newer.HalfHeight, Alpha) / HalfHeightScale;
+	OutCapsule.Radius = Slots[Slot].Radius;
+
+	// States do not blend, take the one of the closer tick.
+	OutCapsule.MovementState = static_cast<ELSMovementState>(Alpha < 0.5f ? Older.MovementState : Newer.MovementState);
+	return true;
+}
@@ -0,0 +1,108 @@
+// Copyright BanMing
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/LocomotionTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+
+#include "LSLagCompensationSubsystem.generated.h"
+
+class ALSCharacterBase;
+
+// Capsule of a character as it was at a past time.
+struct FLSRewoundCapsule
+{
+	ALSCharacterBase* Character = nullptr;
+	FVector Location = FVector::ZeroVector;
+	FRotator Rotation = FRotator::ZeroRotator;
+	float HalfHeight = 0.f;
+	float Radius = 0.f;
+	ELSMovementState MovementState = ELSMovementState::None;
+};
+
+/**
+ * Server side history of the capsules of every registered LS character, for validating hits against where a client saw them.
+ * One sample per character is written every server tick into a ring buffer allocated up front for
+ * LS.LagCompensation.MaxCharacters characters and LS.LagCompensation.HistoryLength ticks, so memory does not grow with play time.
+ * Samples are quantized: location to 1/8 cm in 32 bits per axis, yaw and half-height in 16 bits each.
+ */
+UCLASS()
+class LOCOMOTIONSYSTEM_API ULSLagCompensationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	void RegisterCharacter(ALSCharacterBase* Character);
+	void UnregisterCharacter(ALSCharacterBase* Character);
+
+	// Capsule of the character at the world time, interpolated between the two ticks around it.
+	// False if the character has no history covering the time.
+	bool RewindCharacter(const ALSCharacterBase* Character, double Time, FLSRewoundCapsule& OutCapsule) const;
+
+	// Every character whose capsule at the world time overlaps the sphere, e.g. around a shot's path.
+	int32 RewindRegion(double Time, const FVector& Center, float Radius, TArray<FLSRewoundCapsule>& OutCapsules) const;
+
+	// World time span covered by the history.
+	double GetOldestTime() const;
+	double GetNewestTime() const;
+
+private:
+	struct FSample
+	{
+		// Centimeters * LocationScale.
+		FIntVector Location = FIntVector::ZeroValue;
+		uint16 Yaw = 0;
+
+		// Centimeters * HalfHeightScale.
+		uint16 HalfHeight = 0;
+
+		uint8 MovementState = 0;
+		bool bValid = false;
+	};
+
+	struct FSlot
+	{
+		TWeakObjectPtr<ALSCharacterBase> Character;
+		float Radius = 0.f;
+	};
+
+	static constexpr float HalfHeightScale = 100.f;
+	static constexpr double LocationScale = 8.0;
+
+	// Ring position of the frame Age ticks before the newest one.
+	int32 GetFrameIndex(int32 Age) const
+	{
+		return (NewestFrame - Age + HistoryLength) % HistoryLength;
+	}
+
+	const FSample& GetSample(int32 Slot, int32 FrameIndex) const
+	{
+		return Samples[Slot * HistoryLength + FrameIndex];
+	}
+
+	// The frames, as ages, the time falls between. False if it is outside the history.
+	bool FindFrames(double Time, int32& OutNewerAge, int32& OutOlderAge, float& OutAlpha) const;
+
+	bool RewindSlot(int32 Slot, int32 NewerAge, int32 OlderAge, float Alpha, FLSRewoundCapsule& OutCapsule) const;
+
+private:
+	int32 HistoryLength = 0;
+
+	// Sample of slot S at frame F is at S * HistoryLength + F.
+	TArray<FSample> Samples;
+	TArray<double> FrameTimes;
+	int32 NewestFrame = INDEX_NONE;
+	int32 NumFrames = 0;
+
+	TArray<FSlot> Slots;
+	TArray<int32> FreeSlots;
+	TMap<TObjectKey<ALSCharacterBase>, int32> SlotIndices;
+};
@@ -0,0 +1,201 @@
+// Copyright BanMing
+
+#include "Subsystems/LSMassLODSubsystem.h"
+
+#include "Characters/LSCharacterBase.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Mass/LSMassFragments.h"
+#include "MassCommonFragments.h"
+#include "MassEntitySubsystem.h"
+#include "Subsystems/LSCharacterPoolSubsystem.h"
+
+static TAutoConsoleVariable<float> CVarMassLODConvertDistance(TEXT("LS.MassLOD.ConvertDistance"), 10000.f, TEXT("Registered characters further than this from every view turn into Mass entities."));
+static TAutoConsoleVariable<float> CVarMassLODRestoreDistance(TEXT("LS.MassLOD.RestoreDistance"), 9000.f, TEXT("Mass entities closer than this to a view turn back into characters."));
+static TAutoConsoleVariable<int32> CVarMassLODMaxConversionsPerFrame(TEXT("LS.MassLOD.MaxConversionsPerFrame"), 8, TEXT("Maximum number of conversions each way per frame."));
+
+bool ULSMassLODSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld() && World->GetNetMode() == NM_Standalone;
+}
+
+void ULSMassLODSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	EntitySubsystem = Collection.InitializeDependency<UMassEntitySubsystem>();
+	CharacterPool = Collection.InitializeDependency<ULSCharacterPoolSubsystem>();
+}
+
+void ULSMassLODSubsystem::Deinitialize()
+{
+	Characters.Empty();
+	Entities.Empty();
+	EntitySubsystem = nullptr;
+	CharacterPool = nullptr;
+	Super::Deinitialize();
+}
+
+void ULSMassLODSubsystem::Tick(float DeltaTime)
+{
+	if (EntitySubsystem == nullptr || CharacterPool == nullptr)
+	{
+		return;
+	}
+
+	ViewLocations.Reset();
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		if (PlayerController && PlayerController->IsLocalController())
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+			ViewLocations.Add(ViewLocation);
+		}
+	}
+
+	// Nothing is far or close without a view.
+	if (ViewLocations.Num() == 0)
+	{
+		return;
+	}
+
+	const int32 MaxConversions = CVarMassLODMaxConversionsPerFrame.GetValueOnGameThread();
+	const float ConvertDistanceSquared = FMath::Square(CVarMassLODConvertDistance.GetValueOnGameThread());
+	const float RestoreDistanceSquared = FMath::Square(CVarMassLODRestoreDistance.GetValueOnGameThread());
+
+	// Restore first, so a character and its entity never both exist within one frame.
+	const FMassEntityManager& EntityManager = EntitySubsystem->GetEntityManager();
+	int32 Conversions = 0;
+	for (int32 Index = Entities.Num() - 1; Index >= 0 && Conversions < MaxConversions; --Index)
+	{
+		const FMassEntityHandle Entity = Entities[Index];
+		if (!EntityManager.IsEntityValid(Entity))
+		{
+			Entities.RemoveAtSwap(Index);
+			continue;
+		}
+
+		const FVector Location = EntityManager.GetFragmentDataChecked<FTransformFragment>(Entity).GetTransform().GetLocation();
+		if (GetClosestViewDistanceSquared(Location) < RestoreDistanceSquared && ConvertToCharacter(Entity))
+		{
+			Entities.RemoveAtSwap(Index);
+			++Conversions;
+		}
+	}
+
+	Conversions = 0;
+	for (int32 Index = Characters.Num() - 1; Index >= 0 && Conversions < MaxConversions; --Index)
+	{
+		ALSCharacterBase* Character = Characters[Index].Get();
+		if (!IsValid(Character))
+		{
+			Characters.RemoveAtSwap(Index);
+			continue;
+		}
+
+		if (Character->CanConvertToMassEntity() && GetClosestViewDistanceSquared(Character->GetActorLocation()) > ConvertDistanceSquared && ConvertToEntity(*Character))
+		{
+			Characters.RemoveAtSwap(Index);
+			++Conversions;
+		}
+	}
+}
+
+TStatId ULSMassLODSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULSMassLODSubsystem, STATGROUP_Tickables);
+}
+
+void ULSMassLODSubsystem::RegisterCharacter(ALSCharacterBase* Character)
+{
+	if (IsValid(Character))
+	{
+		Characters.AddUnique(Character);
+	}
+}
+
+void ULSMassLODSubsystem::UnregisterCharacter(ALSCharacterBase* Character)
+{
+	Characters.RemoveSwap(Character);
+}
+
+bool ULSMassLODSubsystem::ConvertToEntity(ALSCharacterBase& Character)
+{
+	FMassEntityManager& EntityManager = EntitySubsystem->GetMutableEntityManager();
+	if (!Archetype.IsValid())
+	{
+		FMassArchetypeCompositionDescriptor Composition;
+		Composition.Fragments.Add<FTransformFragment>();
+		Composition.Fragments.Add<FLSLocomotionFragment>();
+		Composition.Fragments.Add<FLSMassParkedCharacterFragment>();
+		Composition.Tags.Add<FLSMassLocomotionTag>();
+		Composition.ConstSharedFragments.Add<FLSMassCharacterFragment>();
+		Archetype = EntityManager.CreateArchetype(Composition, TEXT("LSLocomotion"));
+	}
+
+	// Shared per character class, which also decides the movement model.
+	FLSMassCharacterFragment CharacterFragment;
+	CharacterFragment.CharacterClass = Character.GetClass();
+	CharacterFragment.MovementModel = Character.GetMovementModelHandle();
+	if (!CharacterFragment.MovementModel.IsValid())
+	{
+		return false;
+	}
+
+	FMassArchetypeSharedFragmentValues SharedValues;
+	SharedValues.AddConstSharedFragment(EntityManager.GetOrCreateConstSharedFragment(CharacterFragment));
+	SharedValues.Sort();
+
+	const FMassEntityHandle Entity = EntityManager.CreateEntity(Archetype, SharedValues);
+	EntityManager.GetFragmentDataChecked<FTransformFragment>(Entity).SetTransform(Character.GetActorTransform());
+	Character.GetLocomotionFragment(EntityManager.GetFragmentDataChecked<FLSLocomotionFragment>(Entity));
+	EntityManager.GetFragmentDataChecked<FLSMassParkedCharacterFragment>(Entity).Character = &Character;
+	Entities.Add(Entity);
+
+	// Drop everything the character registered elsewhere (shared animation, climbing IK, pending traces) before parking it.
+	// Parked rather than released, so no one else acquires it and the entity turns back into this actor, controller included.
+	Character.ResetLocomotionState();
+	CharacterPool->Park(&Character);
+	return true;
+}
+
+bool ULSMassLODSubsystem::ConvertToCharacter(const FMassEntityHandle& Entity)
+{
+	FMassEntityManager& EntityManager = EntitySubsystem->GetMutableEntityManager();
+	const TSubclassOf<ALSCharacterBase> CharacterClass = EntityManager.GetConstSharedFragmentDataChecked<FLSMassCharacterFragment>(Entity).CharacterClass;
+	const FTransform Transform = EntityManager.GetFragmentDataChecked<FTransformFragment>(Entity).GetTransform();
+
+	// The parked actor can only be gone if something destroyed it meanwhile, a pooled one of its class stands in then.
+	ALSCharacterBase* Character = EntityManager.GetFragmentDataChecked<FLSMassParkedCharacterFragment>(Entity).Character.Get();
+	if (IsValid(Character))
+	{
+		CharacterPool->Unpark(Character, Transform);
+	}
+	else
+	{
+		Character = CharacterPool->Acquire(CharacterClass, Transform);
+	}
+
+	if (Character == nullptr)
+	{
+		return false;
+	}
+
+	Character->ApplyLocomotionFragment(EntityManager.GetFragmentDataChecked<FLSLocomotionFragment>(Entity));
+	EntityManager.DestroyEntity(Entity);
+	Characters.AddUnique(Character);
+	return true;
+}
+
+float ULSMassLODSubsystem::GetClosestViewDistanceSquared(const FVector& Location) const
+{
+	float ClosestDistanceSquared = MAX_flt;
+	for (const FVector& ViewLocation : ViewLocations)
+	{
+		ClosestDistanceSquared = FMath::Min(ClosestDistanceSquared, static_cast<float>(FVector::DistSquared(ViewLocation, Location)));
+	}
+	return ClosestDistanceSquared;
+}
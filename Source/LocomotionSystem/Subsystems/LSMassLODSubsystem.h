@@ -0,0 +1,59 @@
+// Copyright BanMing
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "LSMassLODSubsystem.generated.h"
+
+class ALSCharacterBase;
+class ULSCharacterPoolSubsystem;
+class UMassEntitySubsystem;
+
+/**
+ * Turns registered LS characters far from every view into Mass entities moved by ULSMassLocomotionProcessor,
+ * parking the actors hidden with their AI paused, and turns each entity back into its own actor with its locomotion state once a view gets close.
+ * Only runs in standalone games, a server cannot hand replicated characters over to entities its clients never see.
+ */
+UCLASS()
+class LOCOMOTIONSYSTEM_API ULSMassLODSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	void RegisterCharacter(ALSCharacterBase* Character);
+	void UnregisterCharacter(ALSCharacterBase* Character);
+
+	int32 GetNumEntities() const
+	{
+		return Entities.Num();
+	}
+
+private:
+	bool ConvertToEntity(ALSCharacterBase& Character);
+	bool ConvertToCharacter(const FMassEntityHandle& Entity);
+
+	float GetClosestViewDistanceSquared(const FVector& Location) const;
+
+private:
+	UPROPERTY(Transient)
+	TObjectPtr<UMassEntitySubsystem> EntitySubsystem;
+
+	UPROPERTY(Transient)
+	TObjectPtr<ULSCharacterPoolSubsystem> CharacterPool;
+
+	TArray<TWeakObjectPtr<ALSCharacterBase>> Characters;
+	TArray<FMassEntityHandle> Entities;
+	FMassArchetypeHandle Archetype;
+
+	// Gathered once per tick.
+	TArray<FVector, TInlineAllocator<4>> ViewLocations;
+};
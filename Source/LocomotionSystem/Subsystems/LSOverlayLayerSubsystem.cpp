@@ -0,0 +1,87 @@
+// Copyright BanMing
+
+#include "Subsystems/LSOverlayLayerSubsystem.h"
+
+#include "Animation/AnimInstance.h"
+#include "Engine/AssetManager.h"
+
+void ULSOverlayLayerSubsystem::Deinitialize()
+{
+	for (TPair<FSoftObjectPath, FLayerEntry>& Pair : Layers)
+	{
+		if (Pair.Value.Handle.IsValid())
+		{
+			Pair.Value.Handle->ReleaseHandle();
+		}
+	}
+	Layers.Empty();
+
+	Super::Deinitialize();
+}
+
+void ULSOverlayLayerSubsystem::RequestLayer(const TSoftClassPtr<UAnimInstance>& LayerClass, FOnOverlayLayerReady OnReady)
+{
+	check(IsInGameThread());
+
+	const FSoftObjectPath LayerPath = LayerClass.ToSoftObjectPath();
+	if (LayerPath.IsNull())
+	{
+		OnReady.ExecuteIfBound(nullptr);
+		return;
+	}
+
+	FLayerEntry& Entry = Layers.FindOrAdd(LayerPath);
+	++Entry.NumUsers;
+
+	if (Entry.Handle.IsValid() && Entry.Handle->HasLoadCompleted())
+	{
+		OnReady.ExecuteIfBound(LayerClass.Get());
+		return;
+	}
+
+	Entry.PendingCallbacks.Add(MoveTemp(OnReady));
+	if (!Entry.Handle.IsValid())
+	{
+		// Keep the handle so the class stays resident until the last user releases it.
+		TSharedPtr<FStreamableHandle> Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(LayerPath, FStreamableDelegate::CreateUObject(this, &ThisClass::HandleLayerLoaded, LayerPath), FStreamableManager::AsyncLoadHighPriority, true);
+		if (FLayerEntry* StillRequested = Layers.Find(LayerPath))
+		{
+			StillRequested->Handle = Handle;
+		}
+	}
+}
+
+void ULSOverlayLayerSubsystem::ReleaseLayer(const TSoftClassPtr<UAnimInstance>& LayerClass)
+{
+	const FSoftObjectPath LayerPath = LayerClass.ToSoftObjectPath();
+	FLayerEntry* Entry = Layers.Find(LayerPath);
+	if (Entry == nullptr)
+	{
+		return;
+	}
+
+	if (--Entry->NumUsers <= 0)
+	{
+		if (Entry->Handle.IsValid())
+		{
+			Entry->Handle->ReleaseHandle();
+		}
+		Layers.Remove(LayerPath);
+	}
+}
+
+void ULSOverlayLayerSubsystem::HandleLayerLoaded(FSoftObjectPath LayerPath)
+{
+	FLayerEntry* Entry = Layers.Find(LayerPath);
+	if (Entry == nullptr)
+	{
+		return;
+	}
+
+	TSubclassOf<UAnimInstance> LoadedClass = Cast<UClass>(LayerPath.ResolveObject());
+	TArray<FOnOverlayLayerReady> Callbacks = MoveTemp(Entry->PendingCallbacks);
+	for (FOnOverlayLayerReady& Callback : Callbacks)
+	{
+		Callback.ExecuteIfBound(LoadedClass);
+	}
+}
@@ -0,0 +1,46 @@
+// Copyright BanMing
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/SoftObjectPtr.h"
+
+#include "LSOverlayLayerSubsystem.generated.h"
+
+class UAnimInstance;
+struct FStreamableHandle;
+
+DECLARE_DELEGATE_OneParam(FOnOverlayLayerReady, TSubclassOf<UAnimInstance>);
+
+/**
+ * Streams overlay anim layer classes in on demand and keeps them resident while any character uses them.
+ * Every RequestLayer must be matched by a ReleaseLayer; the class is released once its last user is gone.
+ */
+UCLASS()
+class LOCOMOTIONSYSTEM_API ULSOverlayLayerSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// Add a user to the layer class and call back once it is loaded. Calls back immediately if it is already resident.
+	void RequestLayer(const TSoftClassPtr<UAnimInstance>& LayerClass, FOnOverlayLayerReady OnReady);
+
+	// Remove a user from the layer class.
+	void ReleaseLayer(const TSoftClassPtr<UAnimInstance>& LayerClass);
+
+private:
+	void HandleLayerLoaded(FSoftObjectPath LayerPath);
+
+private:
+	struct FLayerEntry
+	{
+		TSharedPtr<FStreamableHandle> Handle;
+		TArray<FOnOverlayLayerReady> PendingCallbacks;
+		int32 NumUsers = 0;
+	};
+
+	TMap<FSoftObjectPath, FLayerEntry> Layers;
+};
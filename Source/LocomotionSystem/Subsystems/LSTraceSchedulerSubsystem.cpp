@@ -0,0 +1,257 @@
+// Copyright BanMing
+
+#include "Subsystems/LSTraceSchedulerSubsystem.h"
+
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+
+static TAutoConsoleVariable<int32> CVarTraceMaxPerFrame(TEXT("LS.Traces.MaxPerFrame"), 64, TEXT("Maximum number of locomotion traces submitted per frame, the rest wait in priority order."));
+static TAutoConsoleVariable<float> CVarTraceNearbyDistance(TEXT("LS.Traces.NearbyDistance"), 2500.f, TEXT("AI closer than this to a player view get the nearby trace priority."));
+
+// Results nobody polled for are dropped after this long.
+static constexpr double UnpolledResultLifetime = 1.0;
+
+bool ULSTraceSchedulerSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// Landing prediction drives movement, so unlike the cosmetic subsystems this also runs on servers.
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+void ULSTraceSchedulerSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	TraceDelegate.BindUObject(this, &ULSTraceSchedulerSubsystem::OnTraceCompleted);
+}
+
+void ULSTraceSchedulerSubsystem::Deinitialize()
+{
+	Queue.Empty();
+	QueuedIds.Empty();
+	InFlight.Empty();
+	Completed.Empty();
+	TraceDelegate.Unbind();
+	Super::Deinitialize();
+}
+
+void ULSTraceSchedulerSubsystem::Tick(float DeltaTime)
+{
+	const double Now = GetWorld()->GetTimeSeconds();
+	for (auto It = Completed.CreateIterator(); It; ++It)
+	{
+		if (Now - It->Value.CompletedTime > UnpolledResultLifetime)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	if (Queue.Num() == 0)
+	{
+		return;
+	}
+
+	// Most urgent first, first come first served within the same priority and deadline.
+	Queue.Sort([](const FQueuedTrace& A, const FQueuedTrace& B) {
+		if (A.Request.Priority != B.Request.Priority)
+		{
+			return A.Request.Priority < B.Request.Priority;
+		}
+		const double DeadlineA = A.Request.Deadline > 0.0 ? A.Request.Deadline : MAX_dbl;
+		const double DeadlineB = B.Request.Deadline > 0.0 ? B.Request.Deadline : MAX_dbl;
+		if (DeadlineA != DeadlineB)
+		{
+			return DeadlineA < DeadlineB;
+		}
+		return A.Ticket.Id < B.Ticket.Id;
+	});
+
+	// Callbacks may queue new traces, so the expired ones are only reported once the queue is rebuilt.
+	TArray<FQueuedTrace> Pending = MoveTemp(Queue);
+	TArray<FQueuedTrace> Expired;
+	const int32 Budget = CVarTraceMaxPerFrame.GetValueOnGameThread();
+	int32 Submitted = 0;
+	for (FQueuedTrace& Queued : Pending)
+	{
+		if (Queued.Request.Deadline > 0.0 && Queued.Request.Deadline < Now)
+		{
+			QueuedIds.Remove(Queued.Ticket.Id);
+			Expired.Add(MoveTemp(Queued));
+		}
+		else if (Submitted < Budget)
+		{
+			QueuedIds.Remove(Queued.Ticket.Id);
+			SubmitTrace(Queued);
+			++Submitted;
+		}
+		else
+		{
+			Queue.Add(MoveTemp(Queued));
+		}
+	}
+
+	FLSTraceResult ExpiredResult;
+	ExpiredResult.Status = ELSTraceStatus::Expired;
+	for (FQueuedTrace& Queued : Expired)
+	{
+		Complete(Queued.Ticket, Queued.Request.OnCompleted, ExpiredResult);
+	}
+}
+
+TStatId ULSTraceSchedulerSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULSTraceSchedulerSubsystem, STATGROUP_Tickables);
+}
+
+FLSTraceTicket ULSTraceSchedulerSubsystem::RequestTrace(FLSTraceRequest&& Request)
+{
+	FQueuedTrace& Queued = Queue.AddDefaulted_GetRef();
+	Queued.Ticket.Id = NextTicketId++;
+	if (NextTicketId == 0)
+	{
+		NextTicketId = 1;
+	}
+	Queued.Request = MoveTemp(Request);
+	QueuedIds.Add(Queued.Ticket.Id);
+	return Queued.Ticket;
+}
+
+void ULSTraceSchedulerSubsystem::CancelTrace(FLSTraceTicket& Ticket)
+{
+	if (!Ticket.IsValid())
+	{
+		return;
+	}
+
+	if (QueuedIds.Remove(Ticket.Id) > 0)
+	{
+		Queue.RemoveAll([&Ticket](const FQueuedTrace& Queued) { return Queued.Ticket == Ticket; });
+	}
+	InFlight.Remove(Ticket.Id);
+	Completed.Remove(Ticket.Id);
+	Ticket.Reset();
+}
+
+ELSTraceStatus ULSTraceSchedulerSubsystem::GetStatus(FLSTraceTicket Ticket) const
+{
+	if (!Ticket.IsValid())
+	{
+		return ELSTraceStatus::Invalid;
+	}
+	if (QueuedIds.Contains(Ticket.Id))
+	{
+		return ELSTraceStatus::Queued;
+	}
+	if (InFlight.Contains(Ticket.Id))
+	{
+		return ELSTraceStatus::InFlight;
+	}
+	if (const FCompletedTrace* Result = Completed.Find(Ticket.Id))
+	{
+		return Result->Result.Status;
+	}
+	return ELSTraceStatus::Invalid;
+}
+
+bool ULSTraceSchedulerSubsystem::ConsumeResult(FLSTraceTicket& Ticket, FLSTraceResult& OutResult)
+{
+	FCompletedTrace Result;
+	if (!Ticket.IsValid() || !Completed.RemoveAndCopyValue(Ticket.Id, Result))
+	{
+		return false;
+	}
+
+	OutResult = MoveTemp(Result.Result);
+	Ticket.Reset();
+	return true;
+}
+
+ELSTracePriority ULSTraceSchedulerSubsystem::GetPriority(const AActor* Instigator) const
+{
+	const APawn* Pawn = Cast<APawn>(Instigator);
+	if (Pawn && Pawn->IsPlayerControlled())
+	{
+		return ELSTracePriority::Player;
+	}
+	if (Instigator == nullptr)
+	{
+		return ELSTracePriority::DistantAI;
+	}
+
+	const FVector Location = Instigator->GetActorLocation();
+	const float NearbyDistanceSquared = FMath::Square(CVarTraceNearbyDistance.GetValueOnGameThread());
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		if (PlayerController == nullptr)
+		{
+			continue;
+		}
+
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+		if (FVector::DistSquared(ViewLocation, Location) <= NearbyDistanceSquared)
+		{
+			return ELSTracePriority::NearbyAI;
+		}
+	}
+
+	return ELSTracePriority::DistantAI;
+}
+
+void ULSTraceSchedulerSubsystem::SubmitTrace(FQueuedTrace& Queued)
+{
+	UWorld* World = GetWorld();
+	const FLSTraceRequest& Request = Queued.Request;
+	if (Request.Shape.IsLine())
+	{
+		World->AsyncLineTraceByChannel(EAsyncTraceType::Single, Request.Start, Request.End, Request.Channel, Request.Params, Request.ResponseParams, &TraceDelegate, Queued.Ticket.Id);
+	}
+	else
+	{
+		World->AsyncSweepByChannel(EAsyncTraceType::Single, Request.Start, Request.End, Request.Rotation, Request.Channel, Request.Shape, Request.Params, Request.ResponseParams, &TraceDelegate,
+								   Queued.Ticket.Id);
+	}
+
+	InFlight.Add(Queued.Ticket.Id, MoveTemp(Queued.Request.OnCompleted));
+}
+
+void ULSTraceSchedulerSubsystem::OnTraceCompleted(const FTraceHandle& Handle, FTraceDatum& Datum)
+{
+	// Cancelled traces are no longer in flight and their result is dropped here.
+	FLSTraceTicket Ticket;
+	Ticket.Id = static_cast<uint32>(Datum.UserData);
+	FOnLSTraceCompleted OnCompleted;
+	if (!InFlight.RemoveAndCopyValue(Ticket.Id, OnCompleted))
+	{
+		return;
+	}
+
+	FLSTraceResult Result;
+	const FHitResult* Hit = Datum.OutHits.FindByPredicate([](const FHitResult& Entry) { return Entry.bBlockingHit; });
+	if (Hit)
+	{
+		Result.Status = ELSTraceStatus::Hit;
+		Result.Hit = *Hit;
+	}
+	else
+	{
+		Result.Status = ELSTraceStatus::Miss;
+	}
+
+	Complete(Ticket, OnCompleted, Result);
+}
+
+void ULSTraceSchedulerSubsystem::Complete(FLSTraceTicket Ticket, FOnLSTraceCompleted& OnCompleted, const FLSTraceResult& Result)
+{
+	if (OnCompleted.IsBound())
+	{
+		OnCompleted.Execute(Ticket, Result);
+		return;
+	}
+
+	FCompletedTrace& Entry = Completed.Add(Ticket.Id);
+	Entry.Result = Result;
+	Entry.CompletedTime = GetWorld()->GetTimeSeconds();
+}
@@ -0,0 +1,153 @@
+// Copyright BanMing
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/HitResult.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "WorldCollision.h"
+
+#include "LSTraceSchedulerSubsystem.generated.h"
+
+UENUM(BlueprintType)
+enum class ELSTracePriority : uint8
+{
+	Player,
+	NearbyAI,
+	DistantAI
+};
+
+enum class ELSTraceStatus : uint8
+{
+	// Unknown ticket, or its result was already consumed.
+	Invalid,
+	Queued,
+	InFlight,
+	Hit,
+	Miss,
+	// Not submitted before its deadline.
+	Expired
+};
+
+struct FLSTraceTicket
+{
+	uint32 Id = 0;
+
+	bool IsValid() const
+	{
+		return Id != 0;
+	}
+
+	void Reset()
+	{
+		Id = 0;
+	}
+
+	bool operator==(const FLSTraceTicket& Other) const
+	{
+		return Id == Other.Id;
+	}
+
+	bool operator!=(const FLSTraceTicket& Other) const
+	{
+		return Id != Other.Id;
+	}
+};
+
+struct FLSTraceResult
+{
+	ELSTraceStatus Status = ELSTraceStatus::Invalid;
+	FHitResult Hit;
+};
+
+DECLARE_DELEGATE_TwoParams(FOnLSTraceCompleted, FLSTraceTicket /*Ticket*/, const FLSTraceResult& /*Result*/);
+
+struct FLSTraceRequest
+{
+	FVector Start = FVector::ZeroVector;
+	FVector End = FVector::ZeroVector;
+
+	// A line shape traces, anything else sweeps.
+	FCollisionShape Shape;
+	FQuat Rotation = FQuat::Identity;
+
+	ECollisionChannel Channel = ECC_Visibility;
+	FCollisionQueryParams Params;
+	FCollisionResponseParams ResponseParams = FCollisionResponseParams::DefaultResponseParam;
+
+	ELSTracePriority Priority = ELSTracePriority::DistantAI;
+
+	// World time the trace has to be submitted by, it expires otherwise. 0 waits for as long as it takes.
+	double Deadline = 0.0;
+
+	// Fired with the result, or with Expired. Without one the result is kept for polling.
+	FOnLSTraceCompleted OnCompleted;
+};
+
+/**
+ * Single entry point for the per-frame locomotion traces (foot IK, landing prediction, climbing probes).
+ * Requests are queued, ordered by priority and deadline, and at most LS.Traces.MaxPerFrame of them are
+ * submitted as async traces each frame, so the trace count is bounded however many characters are active.
+ * Results arrive the frame after submission, through the request's callback or by polling the ticket.
+ */
+UCLASS()
+class LOCOMOTIONSYSTEM_API ULSTraceSchedulerSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	FLSTraceTicket RequestTrace(FLSTraceRequest&& Request);
+
+	// Drop a queued trace, or ignore the result of one in flight.
+	void CancelTrace(FLSTraceTicket& Ticket);
+
+	ELSTraceStatus GetStatus(FLSTraceTicket Ticket) const;
+
+	bool IsPending(FLSTraceTicket Ticket) const
+	{
+		const ELSTraceStatus Status = GetStatus(Ticket);
+		return Status == ELSTraceStatus::Queued || Status == ELSTraceStatus::InFlight;
+	}
+
+	// Take the result of a polled trace once it completed, which releases the ticket.
+	bool ConsumeResult(FLSTraceTicket& Ticket, FLSTraceResult& OutResult);
+
+	// Player controlled pawns first, then by distance to the closest player view.
+	ELSTracePriority GetPriority(const AActor* Instigator) const;
+
+private:
+	struct FQueuedTrace
+	{
+		FLSTraceTicket Ticket;
+		FLSTraceRequest Request;
+	};
+
+	struct FCompletedTrace
+	{
+		FLSTraceResult Result;
+		double CompletedTime = 0.0;
+	};
+
+	void SubmitTrace(FQueuedTrace& Queued);
+	void OnTraceCompleted(const FTraceHandle& Handle, FTraceDatum& Datum);
+	void Complete(FLSTraceTicket Ticket, FOnLSTraceCompleted& OnCompleted, const FLSTraceResult& Result);
+
+private:
+	TArray<FQueuedTrace> Queue;
+	TSet<uint32> QueuedIds;
+
+	// Callbacks of the submitted traces, keyed by ticket id.
+	TMap<uint32, FOnLSTraceCompleted> InFlight;
+
+	// Results waiting to be polled.
+	TMap<uint32, FCompletedTrace> Completed;
+
+	FTraceDelegate TraceDelegate;
+	uint32 NextTicketId = 1;
+};